@@ -28,9 +28,14 @@
 //	modified part of the directory and/or bitmap, we simply discard
 //	the changed version, without writing it back to disk.
 //
+//	Any number of threads may look up names in the directory at once
+//	(Open, List, Print), but a thread changing the directory or the
+//	bitmap (Create, Remove) has both to itself.  The lock that does
+//	this prefers writers, so a steady stream of Opens can't hold off
+//	a Create forever.
+//
 // 	Our implementation at this point has the following restrictions:
 //
-//	   there is no synchronization for concurrent accesses
 //	   files have a fixed size, set when the file is created
 //	   files cannot be bigger than about 3KB in size
 //	   there is no hierarchical directory structure, and only a limited
@@ -52,6 +57,7 @@
 #include "disk.h"
 #include "filehdr.h"
 #include "pbitmap.h"
+#include "synch.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known
@@ -81,6 +87,7 @@
 
 FileSystem::FileSystem(bool format) {
     DEBUG(dbgFile, "Initializing the file system.");
+    dirLock = new ReaderWriterLock("directory", RWPreferWriters);
     if (format) {
         PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
         Directory *directory = new Directory(NumDirEntries);
@@ -164,8 +171,8 @@ FileSystem::FileSystem(bool format) {
 //	 	no free entry for file in directory
 //	 	no free space for data blocks for the file
 //
-// 	Note that this implementation assumes there is no concurrent access
-//	to the file system!
+//	The directory and bitmap are locked against other threads from
+//	the time they are read in until they are written back.
 //
 //	"name" -- name of file to be created
 //	"initialSize" -- size of file to be created
@@ -180,6 +187,7 @@ bool FileSystem::Create(char *name, int initialSize) {
 
     DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
 
+    dirLock->AcquireWrite();
     directory = new Directory(NumDirEntries);
     directory->FetchFrom(directoryFile);
 
@@ -208,6 +216,7 @@ bool FileSystem::Create(char *name, int initialSize) {
         delete freeMap;
     }
     delete directory;
+    dirLock->ReleaseWrite();
     return success;
 }
 
@@ -228,10 +237,12 @@ FileSystem::Open(char *name) {
     int sector;
 
     DEBUG(dbgFile, "Opening file" << name);
+    dirLock->AcquireRead();
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name);
     if (sector >= 0)
         openFile = new OpenFile(sector);  // name was found in directory
+    dirLock->ReleaseRead();
     delete directory;
     return openFile;  // return NULL if not found
 }
@@ -247,6 +258,11 @@ FileSystem::Open(char *name) {
 //	Return TRUE if the file was deleted, FALSE if the file wasn't
 //	in the file system.
 //
+//	We wait for any read or write of the file that is in progress,
+//	then free its blocks at once.  Handles that are still open keep
+//	their own copy of the header, so they must not be used once the
+//	file is removed (the blocks may already belong to another file).
+//
 //	"name" -- the text name of the file to be removed
 //----------------------------------------------------------------------
 
@@ -256,13 +272,16 @@ bool FileSystem::Remove(char *name) {
     FileHeader *fileHdr;
     int sector;
 
+    dirLock->AcquireWrite();
     directory = new Directory(NumDirEntries);
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name);
     if (sector == -1) {
+        dirLock->ReleaseWrite();
         delete directory;
         return FALSE;  // file not found
     }
+    FileHeaderLock(sector)->AcquireWrite();
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
 
@@ -274,6 +293,8 @@ bool FileSystem::Remove(char *name) {
 
     freeMap->WriteBack(freeMapFile);      // flush to disk
     directory->WriteBack(directoryFile);  // flush to disk
+    FileHeaderLock(sector)->ReleaseWrite();
+    dirLock->ReleaseWrite();
     delete fileHdr;
     delete directory;
     delete freeMap;
@@ -288,7 +309,9 @@ bool FileSystem::Remove(char *name) {
 void FileSystem::List() {
     Directory *directory = new Directory(NumDirEntries);
 
+    dirLock->AcquireRead();
     directory->FetchFrom(directoryFile);
+    dirLock->ReleaseRead();
     directory->List();
     delete directory;
 }
@@ -309,6 +332,7 @@ void FileSystem::Print() {
     PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile, NumSectors);
     Directory *directory = new Directory(NumDirEntries);
 
+    dirLock->AcquireRead();
     printf("Bit map file header:\n");
     bitHdr->FetchFrom(FreeMapSector);
     bitHdr->Print();
@@ -321,6 +345,7 @@ void FileSystem::Print() {
 
     directory->FetchFrom(directoryFile);
     directory->Print();
+    dirLock->ReleaseRead();
 
     delete bitHdr;
     delete dirHdr;
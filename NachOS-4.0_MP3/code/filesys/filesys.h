@@ -67,7 +67,7 @@ class FileSystem {
 
     //  The OpenAFile function is used for kernel open system call
     OpenFileId OpenAFile(char *name) {
-	int i = 0;
+	int i = 2;	// 0 and 1 are the console (see syscall.h)
         while (i < 20 && OpenFileTable[i] != NULL) {
             i++;
         }
@@ -120,6 +120,8 @@ class FileSystem {
 };
 
 #else  // FILESYS
+class ReaderWriterLock;
+
 class FileSystem {
    public:
     FileSystem(bool format);  // Initialize the file system.
@@ -145,6 +147,9 @@ class FileSystem {
                               // represented as a file
     OpenFile *directoryFile;  // "Root" directory -- list of
                               // file names, represented as a file
+    ReaderWriterLock *dirLock;  // Held for reading to look in the
+                                // directory, for writing to change
+                                // the directory or the bitmap
 };
 
 #endif  // FILESYS
@@ -7,6 +7,10 @@
 //	Also as in UNIX, for convenience, we keep the file header in
 //	memory while the file is open.
 //
+//	Every open of the same file shares one reader-writer lock, so
+//	that any number of threads can read the file at once, while a
+//	thread writing it, or removing it, has it to itself.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
@@ -17,8 +21,31 @@
 #include "copyright.h"
 #include "filehdr.h"
 #include "main.h"
+#include "synch.h"
 #include "synchdisk.h"
 
+static ReaderWriterLock *headerLocks[NumSectors];  // by header sector;
+                                                   // made on first use
+
+//----------------------------------------------------------------------
+// FileHeaderLock
+// 	Return the lock for the file whose header is at "sector",
+//	creating it the first time the file is used.  Locks are never
+//	deallocated; there is at most one per sector.
+//
+//	The lock is fair: a writer waits only for the readers that
+//	arrived before it, and holds off those that arrive after.
+//----------------------------------------------------------------------
+
+ReaderWriterLock *
+FileHeaderLock(int sector) {
+    ASSERT(sector >= 0 && sector < NumSectors);
+    if (headerLocks[sector] == NULL) {
+        headerLocks[sector] = new ReaderWriterLock("file header", RWFair);
+    }
+    return headerLocks[sector];
+}
+
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
 // 	Open a Nachos file for reading and writing.  Bring the file header
@@ -28,8 +55,11 @@
 //----------------------------------------------------------------------
 
 OpenFile::OpenFile(int sector) {
+    hdrLock = FileHeaderLock(sector);
     hdr = new FileHeader;
+    hdrLock->AcquireRead();
     hdr->FetchFrom(sector);
+    hdrLock->ReleaseRead();
     seekPosition = 0;
 }
 
@@ -103,9 +133,30 @@ int OpenFile::Write(char *into, int numBytes) {
 //	"numBytes" -- the number of bytes to transfer
 //	"position" -- the offset within the file of the first byte to be
 //			read/written
+//
+//	ReadAt shares the file with other readers; WriteAt has it to
+//	itself.  The work is done by UnlockedReadAt/UnlockedWriteAt.
 //----------------------------------------------------------------------
 
 int OpenFile::ReadAt(char *into, int numBytes, int position) {
+    int result;
+
+    hdrLock->AcquireRead();
+    result = UnlockedReadAt(into, numBytes, position);
+    hdrLock->ReleaseRead();
+    return result;
+}
+
+int OpenFile::WriteAt(char *from, int numBytes, int position) {
+    int result;
+
+    hdrLock->AcquireWrite();
+    result = UnlockedWriteAt(from, numBytes, position);
+    hdrLock->ReleaseWrite();
+    return result;
+}
+
+int OpenFile::UnlockedReadAt(char *into, int numBytes, int position) {
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
     char *buf;
@@ -132,7 +183,7 @@ int OpenFile::ReadAt(char *into, int numBytes, int position) {
     return numBytes;
 }
 
-int OpenFile::WriteAt(char *from, int numBytes, int position) {
+int OpenFile::UnlockedWriteAt(char *from, int numBytes, int position) {
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
     bool firstAligned, lastAligned;
@@ -155,10 +206,10 @@ int OpenFile::WriteAt(char *from, int numBytes, int position) {
 
     // read in first and last sector, if they are to be partially modified
     if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);
+        UnlockedReadAt(buf, SectorSize, firstSector * SectorSize);
     if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize],
-               SectorSize, lastSector * SectorSize);
+        UnlockedReadAt(&buf[(lastSector - firstSector) * SectorSize],
+                       SectorSize, lastSector * SectorSize);
 
     // copy in the bytes we want to change
     bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
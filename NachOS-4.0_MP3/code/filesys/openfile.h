@@ -9,9 +9,8 @@
 //
 //	The other is the "real" implementation, that turns these
 //	operations into read and write disk sector requests.
-//	In this baseline implementation of the file system, we don't
-//	worry about concurrent accesses to the file system
-//	by different threads.
+//	Threads may read the same file at the same time; writing a file
+//	waits until no one is reading or writing it (see FileHeaderLock).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -67,6 +66,11 @@ class OpenFile {
 
 #else  // FILESYS
 class FileHeader;
+class ReaderWriterLock;
+
+extern ReaderWriterLock *FileHeaderLock(int sector);
+                                // Lock shared by every open of the file
+                                // whose header is at "sector"
 
 class OpenFile {
    public:
@@ -96,6 +100,12 @@ class OpenFile {
    private:
     FileHeader *hdr;   // Header for this file
     int seekPosition;  // Current position within the file
+    ReaderWriterLock *hdrLock;  // Held for reading while the file is
+                                // read, for writing while it's written
+
+    int UnlockedReadAt(char *into, int numBytes, int position);
+    int UnlockedWriteAt(char *from, int numBytes, int position);
+                                // ReadAt/WriteAt, with hdrLock held
 };
 
 #endif  // FILESYS
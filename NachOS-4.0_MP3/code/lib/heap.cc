@@ -0,0 +1,263 @@
+// heap.cc
+//     	Routines to manage a priority queue of "things", kept as
+//	a binary heap in an array.
+//
+//	The array starts out small and is doubled in size whenever it
+//	fills up, so there is no per-item allocation: inserting an item
+//	or taking the smallest one off the heap touches O(log n) slots.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+const int HeapInitialSize = 16;  // slots allocated for a new heap
+
+//----------------------------------------------------------------------
+// Heap<T>::Heap
+//	Initialize a heap, empty to start with.
+//
+//	"comp" orders the items on the heap
+//	"setIdx", if not NULL, is told where each item is on the heap
+//		whenever the item moves
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::Heap(int (*comp)(T x, T y), void (*setIdx)(T x, int index)) {
+    compare = comp;
+    setIndex = setIdx;
+    size = HeapInitialSize;
+    items = new T[size];
+    numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::~Heap
+//	Prepare a heap for deallocation.
+//      This does *NOT* free the items on the heap; as with lists,
+//	that is the caller's job.
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::~Heap() {
+    delete[] items;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Place
+//	Store an item in a slot of the heap, and tell it where it is.
+//----------------------------------------------------------------------
+
+template <class T>
+void Heap<T>::Place(T item, int index) {
+    items[index] = item;
+    if (setIndex != NULL) {
+        (*setIndex)(item, index);
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftUp
+//	Move the item at "index" towards the front of the heap, until
+//	it is no smaller than its parent.
+//----------------------------------------------------------------------
+
+template <class T>
+void Heap<T>::SiftUp(int index) {
+    T item = items[index];
+    int parent;
+
+    while (index > 0) {
+        parent = (index - 1) / 2;
+        if (compare(item, items[parent]) >= 0) {
+            break;
+        }
+        Place(items[parent], index);
+        index = parent;
+    }
+    Place(item, index);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftDown
+//	Move the item at "index" towards the back of the heap, until
+//	it is no larger than either of its children.
+//----------------------------------------------------------------------
+
+template <class T>
+void Heap<T>::SiftDown(int index) {
+    T item = items[index];
+    int child;
+
+    for (;;) {
+        child = 2 * index + 1;
+        if (child >= numInList) {
+            break;
+        }
+        if (child + 1 < numInList &&
+            compare(items[child + 1], items[child]) < 0) {
+            child++;  // pick the smaller child
+        }
+        if (compare(items[child], item) >= 0) {
+            break;
+        }
+        Place(items[child], index);
+        index = child;
+    }
+    Place(item, index);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Insert
+//      Put an "item" onto the heap, growing the array if it is full.
+//----------------------------------------------------------------------
+
+template <class T>
+void Heap<T>::Insert(T item) {
+    if (numInList == size) {
+        T *bigger = new T[size * 2];
+
+        for (int i = 0; i < numInList; i++) {
+            bigger[i] = items[i];
+        }
+        delete[] items;
+        items = bigger;
+        size *= 2;
+    }
+    items[numInList] = item;
+    numInList++;
+    SiftUp(numInList - 1);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::RemoveFront
+//      Remove the smallest item from the heap, and return it.
+//	The heap must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T Heap<T>::RemoveFront() {
+    return Remove(0);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Remove
+//      Remove the item at position "index" from the heap, and return
+//	it.  The last item on the heap is moved into the hole, and then
+//	sifted whichever way it needs to go.
+//----------------------------------------------------------------------
+
+template <class T>
+T Heap<T>::Remove(int index) {
+    T item;
+
+    ASSERT(index >= 0 && index < numInList);
+    item = items[index];
+    numInList--;
+    if (index < numInList) {
+        items[index] = items[numInList];
+        Update(index);
+    }
+    if (setIndex != NULL) {
+        (*setIndex)(item, -1);
+    }
+    return item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Update
+//      The key of the item at "index" has changed; restore the heap
+//	order by moving the item up or down as needed.
+//----------------------------------------------------------------------
+
+template <class T>
+void Heap<T>::Update(int index) {
+    ASSERT(index >= 0 && index < numInList);
+    if (index > 0 && compare(items[index], items[(index - 1) / 2]) < 0) {
+        SiftUp(index);
+    } else {
+        SiftDown(index);
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Apply
+//      Apply function to every item on the heap, in array order.
+//
+//	"func" -- the function to apply
+//----------------------------------------------------------------------
+
+template <class T>
+void Heap<T>::Apply(void (*func)(T)) const {
+    for (int i = 0; i < numInList; i++) {
+        (*func)(items[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SanityCheck
+//      Test whether this is still a legal heap.
+//
+//	Test: is every item no smaller than its parent?
+//----------------------------------------------------------------------
+
+template <class T>
+void Heap<T>::SanityCheck() const {
+    ASSERT(numInList >= 0 && numInList <= size);
+    for (int i = 1; i < numInList; i++) {
+        ASSERT(compare(items[(i - 1) / 2], items[i]) <= 0);
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SelfTest
+//      Test whether this module is working.
+//----------------------------------------------------------------------
+
+template <class T>
+void Heap<T>::SelfTest(T *p, int numEntries) {
+    int i;
+    T *q = new T[numEntries];
+
+    SanityCheck();
+    ASSERT(IsEmpty());
+
+    // put everything in; more than HeapInitialSize entries makes
+    // the array grow
+    for (i = 0; i < numEntries; i++) {
+        Insert(p[i]);
+        ASSERT(!IsEmpty());
+    }
+    SanityCheck();
+
+    // take one out of the middle
+    if (numEntries > 1) {
+        Remove(numInList / 2);
+        SanityCheck();
+    }
+    while (!IsEmpty()) {
+        RemoveFront();
+    }
+
+    for (i = 0; i < numEntries; i++) {
+        Insert(p[i]);
+    }
+    ASSERT(NumInList() == (unsigned int)numEntries);
+
+    // should be able to get out everything we put in
+    for (i = 0; i < numEntries; i++) {
+        q[i] = RemoveFront();
+        SanityCheck();
+    }
+    ASSERT(IsEmpty());
+
+    // make sure everything came out in the right order
+    for (i = 0; i < (numEntries - 1); i++) {
+        ASSERT(compare(q[i], q[i + 1]) <= 0);
+    }
+
+    delete[] q;
+}
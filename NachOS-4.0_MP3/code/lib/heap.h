@@ -0,0 +1,92 @@
+// heap.h
+//	Data structures to manage a priority queue, kept as a binary heap.
+//
+//	A heap is like a sorted list, in that "RemoveFront" always
+//	returns the smallest item, but inserting or removing an item
+//	costs O(log n) instead of O(n), so it stays cheap no matter how
+//	many items are queued up.  Allocation and deallocation of the
+//	items on the heap are to be done by the caller.
+//
+//	Items with equal keys come out in no particular order; if the
+//	caller needs first-in first-out order among equal keys, the
+//	comparison function has to break ties itself (e.g., with a
+//	sequence number).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines a "heap" -- an array of items, arranged
+// so that every item is no larger than the two items below it, and
+// hence the smallest item is always at the front.
+//
+// All types to be inserted onto a heap must have a "Compare"
+// function defined:
+//	   int Compare(T x, T y)
+//		returns -1 if x < y
+//		returns 0 if x == y
+//		returns 1 if x > y
+//
+// If the caller needs to remove an item from the middle of the heap,
+// or to change an item's key while it is on the heap, it can supply
+// a "SetIndex" function, which is called with the item's new position
+// every time the item moves.  The position can then be passed to
+// Remove or Update.  An item that is not on the heap has index -1.
+
+template <class T>
+class Heap {
+   public:
+    Heap(int (*comp)(T x, T y), void (*setIdx)(T x, int index) = NULL);
+    // initialize an empty heap
+    ~Heap();  // de-allocate the heap
+
+    void Insert(T item);  // put an item onto the heap
+
+    T Front() {
+        ASSERT(!IsEmpty());
+        return items[0];
+    }
+    // Return the smallest item
+    // without removing it
+    T RemoveFront();  // Take the smallest item off the heap
+    T Remove(int index);  // Take the item at "index" off the heap
+    void Update(int index);  // The key of the item at "index" changed;
+                             // move it to its proper place
+
+    unsigned int NumInList() { return numInList; }
+    // how many items on the heap?
+    bool IsEmpty() { return (numInList == 0); }
+    // is the heap empty?
+
+    void Apply(void (*f)(T)) const;
+    // apply function to all items on the heap,
+    // in no particular order
+
+    void SanityCheck() const;  // has this heap been corrupted?
+    void SelfTest(T *p, int numEntries);
+    // verify module is working
+
+   private:
+    T *items;         // the heap; the children of items[i] are
+                      // items[2i+1] and items[2i+2]
+    int numInList;    // number of items on the heap
+    int size;         // number of items the array can hold
+    int (*compare)(T x, T y);           // function for ordering items
+    void (*setIndex)(T x, int index);   // tell an item where it is,
+                                        // NULL if nobody cares
+
+    void Place(T item, int index);  // store "item" at "index"
+    void SiftUp(int index);         // move an item towards the front
+    void SiftDown(int index);       // move an item towards the back
+};
+
+#include "heap.cc"  // templates are really like macros
+                    // so needs to be included in every
+                    // file that uses the template
+#endif  // HEAP_H
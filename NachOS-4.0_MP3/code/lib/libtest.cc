@@ -1,6 +1,7 @@
 // libtest.cc
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists, heaps, red-black trees,
+//	and hash tables.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -11,7 +12,9 @@
 #include "bitmap.h"
 #include "copyright.h"
 #include "hash.h"
+#include "heap.h"
 #include "list.h"
+#include "rbtree.h"
 #include "sysdep.h"
 
 //----------------------------------------------------------------------
@@ -57,6 +60,16 @@ HashKey(char *str) {
 // Array of values to be inserted into a List or SortedList.
 static int listTestVector[] = {9, 5, 7};
 
+// Array of values to be inserted into a Heap.
+// There are enough here to force the heap to grow, and some repeats.
+static int heapTestVector[] = {9, 5, 7, 12, 3, 18, 5, 1, 14, 6, 20, 2,
+                               9, 11, 16, 4, 8, 19, 13, 3, 10, 17, 15, 0};
+
+// Array of values to be inserted into a red-black tree.
+// They must all be different.
+static int rbTreeTestVector[] = {9, 5, 7, 12, 3, 18, 1, 14, 6, 20, 2,
+                                 11, 16, 4, 8, 19, 13, 10, 17, 15, 0};
+
 // Array of values to be inserted into the HashTable
 // There are enough here to force a ReHash().
 static char *hashTestVector[] = {"0", "1", "2", "3", "4", "5", "6",
@@ -64,24 +77,30 @@ static char *hashTestVector[] = {"0", "1", "2", "3", "4", "5", "6",
 
 //----------------------------------------------------------------------
 // LibSelfTest
-//	Run self tests on bitmaps, lists, sorted lists, and
-//	hash tables.
+//	Run self tests on bitmaps, lists, sorted lists, heaps,
+//	red-black trees, and hash tables.
 //----------------------------------------------------------------------
 
 void LibSelfTest() {
     Bitmap *map = new Bitmap(200);
     List<int> *list = new List<int>;
     SortedList<int> *sortList = new SortedList<int>(IntCompare);
+    Heap<int> *heap = new Heap<int>(IntCompare);
+    RBTree<int> *rbTree = new RBTree<int>(IntCompare);
     HashTable<int, char *> *hashTable =
         new HashTable<int, char *>(HashKey, HashInt);
 
     map->SelfTest();
     list->SelfTest(listTestVector, sizeof(listTestVector) / sizeof(int));
     sortList->SelfTest(listTestVector, sizeof(listTestVector) / sizeof(int));
+    heap->SelfTest(heapTestVector, sizeof(heapTestVector) / sizeof(int));
+    rbTree->SelfTest(rbTreeTestVector, sizeof(rbTreeTestVector) / sizeof(int));
     hashTable->SelfTest(hashTestVector, sizeof(hashTestVector) / sizeof(char *));
 
     delete map;
     delete list;
     delete sortList;
+    delete heap;
+    delete rbTree;
     delete hashTable;
 }
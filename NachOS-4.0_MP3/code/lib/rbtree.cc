@@ -0,0 +1,456 @@
+// rbtree.cc
+//     	Routines to manage a red-black tree of "things".
+//
+//	The algorithms are the usual ones (see Cormen, Leiserson, Rivest
+//	and Stein, "Introduction to Algorithms", chapter 13): insert or
+//	delete as in an ordinary binary search tree, then recolor and
+//	rotate on the way back up to restore the red-black properties.
+//	A single black sentinel node, "nil", stands in for every missing
+//	child, and for the parent of the root.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+//----------------------------------------------------------------------
+// RBTree<T>::RBTree
+//	Initialize a tree, empty to start with.
+//
+//	"comp" orders the items in the tree
+//----------------------------------------------------------------------
+
+template <class T>
+RBTree<T>::RBTree(int (*comp)(T x, T y)) {
+    compare = comp;
+    nil = new RBNode<T>;
+    nil->left = nil->right = nil->parent = nil;
+    nil->red = FALSE;
+    root = nil;
+    numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::~RBTree
+//	Prepare a tree for deallocation.  If the tree still contains
+//	any nodes, de-allocate them.  However, note that we do *not*
+//	de-allocate the "items" in the tree -- the caller must do that.
+//----------------------------------------------------------------------
+
+template <class T>
+RBTree<T>::~RBTree() {
+    DeleteAll(root);
+    delete nil;
+}
+
+template <class T>
+void RBTree<T>::DeleteAll(RBNode<T> *node) {
+    if (node != nil) {
+        DeleteAll(node->left);
+        DeleteAll(node->right);
+        delete node;
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Minimum
+//	Return the leftmost node at or below "node".
+//----------------------------------------------------------------------
+
+template <class T>
+RBNode<T> *RBTree<T>::Minimum(RBNode<T> *node) const {
+    ASSERT(node != nil);
+    while (node->left != nil) {
+        node = node->left;
+    }
+    return node;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Find
+//	Return the node that holds "item", or "nil" if it is not in
+//	the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+RBNode<T> *RBTree<T>::Find(T item) const {
+    RBNode<T> *node = root;
+    int cmp;
+
+    while (node != nil && (cmp = compare(item, node->item)) != 0) {
+        node = (cmp < 0) ? node->left : node->right;
+    }
+    return node;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RotateLeft, RotateRight
+//	Rotate the subtree rooted at "node", so that its right (left)
+//	child takes its place, without disturbing the order of the items.
+//----------------------------------------------------------------------
+
+template <class T>
+void RBTree<T>::RotateLeft(RBNode<T> *node) {
+    RBNode<T> *child = node->right;
+
+    node->right = child->left;
+    if (child->left != nil) {
+        child->left->parent = node;
+    }
+    Transplant(node, child);
+    child->left = node;
+    node->parent = child;
+}
+
+template <class T>
+void RBTree<T>::RotateRight(RBNode<T> *node) {
+    RBNode<T> *child = node->left;
+
+    node->left = child->right;
+    if (child->right != nil) {
+        child->right->parent = node;
+    }
+    Transplant(node, child);
+    child->right = node;
+    node->parent = child;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Transplant
+//	Put the subtree rooted at "to" where the subtree rooted at
+//	"from" used to hang.
+//----------------------------------------------------------------------
+
+template <class T>
+void RBTree<T>::Transplant(RBNode<T> *from, RBNode<T> *to) {
+    if (from->parent == nil) {
+        root = to;
+    } else if (from == from->parent->left) {
+        from->parent->left = to;
+    } else {
+        from->parent->right = to;
+    }
+    to->parent = from->parent;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Insert
+//      Put an "item" into the tree, as a red leaf, and then fix up
+//	any red node that now has a red parent.
+//----------------------------------------------------------------------
+
+template <class T>
+void RBTree<T>::Insert(T item) {
+    RBNode<T> *node = new RBNode<T>;
+    RBNode<T> *parent = nil;
+    RBNode<T> *ptr = root;
+
+    node->item = item;
+    node->left = node->right = nil;
+    node->red = TRUE;
+    while (ptr != nil) {
+        parent = ptr;
+        ASSERT(compare(item, ptr->item) != 0);  // no duplicates
+        ptr = (compare(item, ptr->item) < 0) ? ptr->left : ptr->right;
+    }
+    node->parent = parent;
+    if (parent == nil) {
+        root = node;
+    } else if (compare(item, parent->item) < 0) {
+        parent->left = node;
+    } else {
+        parent->right = node;
+    }
+    numInList++;
+    InsertFixup(node);
+}
+
+template <class T>
+void RBTree<T>::InsertFixup(RBNode<T> *node) {
+    RBNode<T> *uncle;
+
+    while (node->parent->red) {
+        RBNode<T> *grand = node->parent->parent;
+
+        if (node->parent == grand->left) {
+            uncle = grand->right;
+            if (uncle->red) {  // recolor, and move up the tree
+                node->parent->red = FALSE;
+                uncle->red = FALSE;
+                grand->red = TRUE;
+                node = grand;
+            } else {
+                if (node == node->parent->right) {
+                    node = node->parent;
+                    RotateLeft(node);
+                }
+                node->parent->red = FALSE;
+                grand->red = TRUE;
+                RotateRight(grand);
+            }
+        } else {  // same, with left and right swapped
+            uncle = grand->left;
+            if (uncle->red) {
+                node->parent->red = FALSE;
+                uncle->red = FALSE;
+                grand->red = TRUE;
+                node = grand;
+            } else {
+                if (node == node->parent->left) {
+                    node = node->parent;
+                    RotateRight(node);
+                }
+                node->parent->red = FALSE;
+                grand->red = TRUE;
+                RotateLeft(grand);
+            }
+        }
+    }
+    root->red = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RemoveFront
+//      Take the smallest item out of the tree, and return it.
+//	The tree must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T RBTree<T>::RemoveFront() {
+    RBNode<T> *node = Minimum(root);
+    T item = node->item;
+
+    Delete(node);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Remove
+//      Take "item" out of the tree.  The item must be in the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+void RBTree<T>::Remove(T item) {
+    RBNode<T> *node = Find(item);
+
+    ASSERT(node != nil);  // should always find item!
+    Delete(node);
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Delete
+//      Unlink "node" from the tree and free it.  If it has two
+//	children, its successor takes its place.  If a black node
+//	was removed from some path, fix up the black heights.
+//----------------------------------------------------------------------
+
+template <class T>
+void RBTree<T>::Delete(RBNode<T> *node) {
+    RBNode<T> *moved = node;  // node actually unlinked from its place
+    RBNode<T> *child;         // what takes the place of "moved"
+    bool movedWasRed = moved->red;
+
+    if (node->left == nil) {
+        child = node->right;
+        Transplant(node, child);
+    } else if (node->right == nil) {
+        child = node->left;
+        Transplant(node, child);
+    } else {
+        moved = Minimum(node->right);
+        movedWasRed = moved->red;
+        child = moved->right;
+        if (moved->parent == node) {
+            child->parent = moved;  // even if child is nil
+        } else {
+            Transplant(moved, child);
+            moved->right = node->right;
+            moved->right->parent = moved;
+        }
+        Transplant(node, moved);
+        moved->left = node->left;
+        moved->left->parent = moved;
+        moved->red = node->red;
+    }
+    delete node;
+    numInList--;
+    if (!movedWasRed) {
+        RemoveFixup(child);
+    }
+}
+
+template <class T>
+void RBTree<T>::RemoveFixup(RBNode<T> *node) {
+    RBNode<T> *sibling;
+
+    while (node != root && !node->red) {
+        if (node == node->parent->left) {
+            sibling = node->parent->right;
+            if (sibling->red) {
+                sibling->red = FALSE;
+                node->parent->red = TRUE;
+                RotateLeft(node->parent);
+                sibling = node->parent->right;
+            }
+            if (!sibling->left->red && !sibling->right->red) {
+                sibling->red = TRUE;
+                node = node->parent;
+            } else {
+                if (!sibling->right->red) {
+                    sibling->left->red = FALSE;
+                    sibling->red = TRUE;
+                    RotateRight(sibling);
+                    sibling = node->parent->right;
+                }
+                sibling->red = node->parent->red;
+                node->parent->red = FALSE;
+                sibling->right->red = FALSE;
+                RotateLeft(node->parent);
+                node = root;
+            }
+        } else {  // same, with left and right swapped
+            sibling = node->parent->left;
+            if (sibling->red) {
+                sibling->red = FALSE;
+                node->parent->red = TRUE;
+                RotateRight(node->parent);
+                sibling = node->parent->left;
+            }
+            if (!sibling->right->red && !sibling->left->red) {
+                sibling->red = TRUE;
+                node = node->parent;
+            } else {
+                if (!sibling->left->red) {
+                    sibling->right->red = FALSE;
+                    sibling->red = TRUE;
+                    RotateLeft(sibling);
+                    sibling = node->parent->left;
+                }
+                sibling->red = node->parent->red;
+                node->parent->red = FALSE;
+                sibling->left->red = FALSE;
+                RotateRight(node->parent);
+                node = root;
+            }
+        }
+    }
+    node->red = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Apply
+//      Apply function to every item in the tree, smallest first.
+//
+//	"func" -- the function to apply
+//----------------------------------------------------------------------
+
+template <class T>
+void RBTree<T>::Apply(void (*func)(T)) const {
+    ApplyBelow(root, func);
+}
+
+template <class T>
+void RBTree<T>::ApplyBelow(RBNode<T> *node, void (*func)(T)) const {
+    if (node != nil) {
+        ApplyBelow(node->left, func);
+        (*func)(node->item);
+        ApplyBelow(node->right, func);
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::SanityCheck
+//      Test whether this is still a legal red-black tree.
+//
+//	Tests: are the items in order?  does a red node have a red
+//	child?  does every path have the same number of black nodes?
+//	does the tree have the right # of items?
+//----------------------------------------------------------------------
+
+template <class T>
+void RBTree<T>::SanityCheck() const {
+    ASSERT(!nil->red && !root->red);
+    ASSERT(root == nil || root->parent == nil);
+    CheckBelow(root);
+}
+
+template <class T>
+int RBTree<T>::CheckBelow(RBNode<T> *node) const {
+    static int numFound;
+    int height;
+
+    if (node == root) {
+        numFound = 0;
+    }
+    if (node == nil) {
+        height = 1;
+    } else {
+        numFound++;
+        if (node->left != nil) {
+            ASSERT(node->left->parent == node);
+            ASSERT(compare(node->left->item, node->item) < 0);
+        }
+        if (node->right != nil) {
+            ASSERT(node->right->parent == node);
+            ASSERT(compare(node->item, node->right->item) < 0);
+        }
+        if (node->red) {
+            ASSERT(!node->left->red && !node->right->red);
+        }
+        height = CheckBelow(node->left);
+        ASSERT(height == CheckBelow(node->right));
+        height += node->red ? 0 : 1;
+    }
+    if (node == root) {
+        ASSERT(numFound == numInList);
+    }
+    return height;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::SelfTest
+//      Test whether this module is working.  The entries must all
+//	be different.
+//----------------------------------------------------------------------
+
+template <class T>
+void RBTree<T>::SelfTest(T *p, int numEntries) {
+    int i;
+    T *q = new T[numEntries];
+
+    SanityCheck();
+    ASSERT(IsEmpty());
+
+    for (i = 0; i < numEntries; i++) {
+        Insert(p[i]);
+        SanityCheck();
+    }
+
+    // take them out again in the order they were put in
+    for (i = 0; i < numEntries; i++) {
+        Remove(p[i]);
+        SanityCheck();
+    }
+    ASSERT(IsEmpty());
+
+    for (i = 0; i < numEntries; i++) {
+        Insert(p[i]);
+    }
+
+    // should be able to get out everything we put in
+    for (i = 0; i < numEntries; i++) {
+        q[i] = RemoveFront();
+        SanityCheck();
+    }
+    ASSERT(IsEmpty());
+
+    // make sure everything came out in the right order
+    for (i = 0; i < (numEntries - 1); i++) {
+        ASSERT(compare(q[i], q[i + 1]) < 0);
+    }
+
+    delete[] q;
+}
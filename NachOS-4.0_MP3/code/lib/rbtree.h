@@ -0,0 +1,96 @@
+// rbtree.h
+//	Data structures to manage a red-black tree -- a balanced binary
+//	search tree.
+//
+//	Like a sorted list, a red-black tree keeps its items in order,
+//	so "RemoveFront" always returns the smallest item, but inserting
+//	or removing any item costs O(log n) instead of O(n).  Allocation
+//	and deallocation of the items in the tree are to be done by the
+//	caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines a node of the tree.  It is private
+// to this module; made public for notational convenience.
+
+template <class T>
+class RBNode {
+   public:
+    T item;           // item in the tree
+    RBNode *left;     // items smaller than this one
+    RBNode *right;    // items larger than this one
+    RBNode *parent;   // node above this one
+    bool red;         // color of the node
+};
+
+// The following class defines a red-black tree.  Every node is red or
+// black; a red node has no red children, and every path from the root
+// down to a leaf passes through the same number of black nodes, so
+// no path is more than twice as long as any other.
+//
+// All types to be inserted into a tree must have a "Compare"
+// function defined, which puts all the items in the tree in a total
+// order (no two items in the tree may compare equal):
+//	   int Compare(T x, T y)
+//		returns -1 if x < y
+//		returns 0 if x == y
+//		returns 1 if x > y
+
+template <class T>
+class RBTree {
+   public:
+    RBTree(int (*comp)(T x, T y));  // initialize an empty tree
+    ~RBTree();                      // de-allocate the tree
+
+    void Insert(T item);  // put an item into the tree
+    void Remove(T item);  // take an item out of the tree
+
+    T Front() { return Minimum(root)->item; }
+    // Return the smallest item
+    // without removing it
+    T RemoveFront();  // Take the smallest item out of the tree
+
+    unsigned int NumInList() { return numInList; }
+    // how many items in the tree?
+    bool IsEmpty() { return (numInList == 0); }
+    // is the tree empty?
+
+    void Apply(void (*f)(T)) const;
+    // apply function to all items in the
+    // tree, smallest first
+
+    void SanityCheck() const;  // has this tree been corrupted?
+    void SelfTest(T *p, int numEntries);
+    // verify module is working
+
+   private:
+    RBNode<T> *root;  // top of the tree, "nil" if empty
+    RBNode<T> *nil;   // stands for every missing child; always black
+    int numInList;    // number of items in the tree
+    int (*compare)(T x, T y);  // function for ordering items
+
+    RBNode<T> *Minimum(RBNode<T> *node) const;  // leftmost node below
+    RBNode<T> *Find(T item) const;              // node holding "item"
+    void RotateLeft(RBNode<T> *node);
+    void RotateRight(RBNode<T> *node);
+    void Transplant(RBNode<T> *from, RBNode<T> *to);
+    void InsertFixup(RBNode<T> *node);
+    void RemoveFixup(RBNode<T> *node);
+    void Delete(RBNode<T> *node);  // unlink and free "node"
+    void DeleteAll(RBNode<T> *node);
+    void ApplyBelow(RBNode<T> *node, void (*f)(T)) const;
+    int CheckBelow(RBNode<T> *node) const;  // returns black height
+};
+
+#include "rbtree.cc"  // templates are really like macros
+                      // so needs to be included in every
+                      // file that uses the template
+#endif  // RBTREE_H
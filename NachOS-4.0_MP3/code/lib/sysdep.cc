@@ -25,6 +25,7 @@
 
 #include "sysdep.h"
 
+#include <poll.h>
 #include <stdlib.h>
 #include <sys/file.h>
 #include <sys/socket.h>
@@ -181,6 +182,21 @@ RandomNumber() {
     return rand();
 }
 
+//----------------------------------------------------------------------
+// HostTime
+// 	Return the time of day on the host, in seconds.  Only the
+//	difference between two readings is meaningful; it is used to
+//	time self tests, in real rather than simulated time.
+//----------------------------------------------------------------------
+
+double
+HostTime() {
+    struct timeval now;
+
+    (void)gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1000000.0;
+}
+
 //----------------------------------------------------------------------
 // AllocBoundedArray
 // 	Return an array, with the two pages just before
@@ -276,6 +292,39 @@ bool PollFile(int fd) {
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// WaitForInput
+// 	Check several open files or sockets to see which have characters
+//	that can be read immediately (or are at end of file).  Return
+//	how many do.
+//
+//	"fds" -- the file descriptors to be polled
+//	"ready" -- set for each file that can be read
+//	"numFds" -- how many files
+//	"timeout" -- how many milliseconds to wait for at least one to
+//		be readable; 0 means don't wait, -1 means wait forever
+//----------------------------------------------------------------------
+
+int WaitForInput(int *fds, bool *ready, int numFds, int timeout) {
+    struct pollfd *pfds = new struct pollfd[numFds];
+    int retVal;
+
+    for (int i = 0; i < numFds; i++) {
+        pfds[i].fd = fds[i];
+        pfds[i].events = POLLIN;
+        pfds[i].revents = 0;
+    }
+    do {
+        retVal = poll(pfds, numFds, timeout);
+    } while (retVal < 0 && errno == EINTR);
+    ASSERT(retVal >= 0);
+    for (int i = 0; i < numFds; i++) {
+        ready[i] = (pfds[i].revents != 0);
+    }
+    delete[] pfds;
+    return retVal;
+}
+
 //----------------------------------------------------------------------
 // OpenForWrite
 // 	Open a file for writing.  Create it if it doesn't exist; truncate it
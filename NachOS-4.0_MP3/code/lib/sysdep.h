@@ -34,6 +34,9 @@ extern void CallOnUserAbort(void (*cleanup)(int));
 extern void RandomInit(unsigned seed);
 extern unsigned int RandomNumber();
 
+// Read the host's wall clock, in seconds; for timing benchmarks
+extern double HostTime();
+
 // Allocate, de-allocate an array, such that de-referencing
 // just beyond either end of the array will cause an error
 extern char *AllocBoundedArray(int size);
@@ -43,6 +46,11 @@ extern void DeallocBoundedArray(char *p, int size);
 // If no characters in the file, return without waiting.
 extern bool PollFile(int fd);
 
+// Check several files at once, marking in "ready" the ones with
+// characters to be read; wait up to "timeout" milliseconds (-1 for
+// as long as it takes) for there to be one.  Return how many are ready.
+extern int WaitForInput(int *fds, bool *ready, int numFds, int timeout);
+
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
 extern int OpenForWrite(char *name);
@@ -35,9 +35,10 @@ ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall) {
     // set up the stuff to emulate asynchronous interrupts
     callWhenAvail = toCall;
     incoming = EOF;
+    head = numBuffered = 0;
 
-    // start polling for incoming keystrokes
-    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+    // start waiting for incoming keystrokes
+    NextChar();
 }
 
 //----------------------------------------------------------------------
@@ -50,41 +51,52 @@ ConsoleInput::~ConsoleInput() {
         Close(readFileNo);
 }
 
+//----------------------------------------------------------------------
+// ConsoleInput::NextChar()
+// 	Arrange for an interrupt when the next character arrives: after
+//	ConsoleTime if one is already in the buffer, otherwise as soon
+//	as the UNIX file has something to read.
+//----------------------------------------------------------------------
+
+void ConsoleInput::NextChar() {
+    if (numBuffered > 0) {
+        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+    } else {
+        kernel->interrupt->WatchInput(readFileNo, this, ConsoleReadInt);
+    }
+}
+
 //----------------------------------------------------------------------
 // ConsoleInput::CallBack()
-// 	Simulator calls this when a character may be available to be
+// 	Simulator calls this when a character is available to be
 //	read in from the simulated keyboard (eg, the user typed something).
 //
-//	First check to make sure character is available.
-//	Then invoke the "callBack" registered by whoever wants the character.
+//	If the buffer is empty, refill it from the file, which has
+//	something to read.  Then invoke the "callBack" registered by
+//	whoever wants the character.
 //----------------------------------------------------------------------
 
 void ConsoleInput::CallBack() {
-    char c;
-    int readCount;
-
     ASSERT(incoming == EOF);
-    if (!PollFile(readFileNo)) {  // nothing to be read
-        // schedule the next time to poll for a packet
-        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
-    } else {
-        // otherwise, try to read a character
-        readCount = ReadPartial(readFileNo, &c, sizeof(char));
-        if (readCount == 0) {
-            // this seems to happen at end of file, when the
+    if (numBuffered == 0) {
+        numBuffered = ReadPartial(readFileNo, buffer, ConsoleBufferSize);
+        head = 0;
+        if (numBuffered <= 0) {
+            // this happens at end of file, when the
             // console input is a regular file
-            // don't schedule an interrupt, since there will never
+            // don't wait for more, since there will never
             // be any more input
-            // just do nothing....
-        } else {
-            // save the character and notify the OS that
-            // it is available
-            ASSERT(readCount == sizeof(char));
-            incoming = c;
-            kernel->stats->numConsoleCharsRead++;
+            numBuffered = 0;
         }
-        callWhenAvail->CallBack();
     }
+    if (numBuffered > 0) {
+        // save the character and notify the OS that
+        // it is available
+        incoming = buffer[head++];
+        numBuffered--;
+        kernel->stats->numConsoleCharsRead++;
+    }
+    callWhenAvail->CallBack();
 }
 
 //----------------------------------------------------------------------
@@ -97,7 +109,7 @@ char ConsoleInput::GetChar() {
     char ch = incoming;
 
     if (incoming != EOF) {  // schedule when next char will arrive
-        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+        NextChar();
     }
     incoming = EOF;
     return ch;
@@ -120,6 +132,7 @@ ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall) {
 
     callWhenDone = toCall;
     putBusy = FALSE;
+    numPutting = 0;
 }
 
 //----------------------------------------------------------------------
@@ -134,14 +147,14 @@ ConsoleOutput::~ConsoleOutput() {
 
 //----------------------------------------------------------------------
 // ConsoleOutput::CallBack()
-// 	Simulator calls this when the next character can be output to the
-//	display.
+// 	Simulator calls this when the characters last put have been
+//	output to the display, and the next ones can be.
 //----------------------------------------------------------------------
 
 void ConsoleOutput::CallBack() {
     DEBUG(dbgTraCode, "In ConsoleOutput::CallBack(), " << kernel->stats->totalTicks);
     putBusy = FALSE;
-    kernel->stats->numConsoleCharsWritten++;
+    kernel->stats->numConsoleCharsWritten += numPutting;
     callWhenDone->CallBack();
 }
 
@@ -152,8 +165,21 @@ void ConsoleOutput::CallBack() {
 //----------------------------------------------------------------------
 
 void ConsoleOutput::PutChar(char ch) {
+    PutBuffer(&ch, 1);
+}
+
+//----------------------------------------------------------------------
+// ConsoleOutput::PutBuffer()
+// 	Write "size" characters to the simulated display, with a single
+//	write to the UNIX file, and schedule one interrupt for when the
+//	display would have taken them all.
+//----------------------------------------------------------------------
+
+void ConsoleOutput::PutBuffer(char *buffer, int size) {
     ASSERT(putBusy == FALSE);
-    WriteFile(writeFileNo, &ch, sizeof(char));
+    ASSERT(size > 0);
+    WriteFile(writeFileNo, buffer, size);
     putBusy = TRUE;
-    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
+    numPutting = size;
+    kernel->interrupt->Schedule(this, size * ConsoleTime, ConsoleWriteInt);
 }
@@ -40,10 +40,17 @@
 // read in (and "callWhenDone" is called when an output character has been
 // "put" so that the next character can be written).
 //
+// Input is read from the UNIX file a chunk at a time, into a buffer
+// in the device, and handed out one character per interrupt; the file
+// is only looked at again once the buffer is empty.
+//
 // In practice, usually a single hardware thing that does both
 // serial input and serial output.  But conceptually simpler to
 // use two objects.
 
+const int ConsoleBufferSize = 256;  // characters read from the UNIX
+                                    // file at a time
+
 class ConsoleInput : public CallBackObj {
    public:
     ConsoleInput(char *readFile, CallBackObj *toCall);
@@ -65,6 +72,12 @@ class ConsoleInput : public CallBackObj {
     char incoming;               // Contains the character to be read,
                                  // if there is one available.
                                  // Otherwise contains EOF.
+    char buffer[ConsoleBufferSize];  // characters read from the file,
+                                     // not yet handed out
+    int head;                    // next character in "buffer"
+    int numBuffered;             // characters left in "buffer"
+
+    void NextChar();  // arrange for the next character to arrive
 };
 
 class ConsoleOutput : public CallBackObj {
@@ -76,6 +89,10 @@ class ConsoleOutput : public CallBackObj {
     void PutChar(char ch);  // Write "ch" to the console display,
                             // and return immediately.  "callWhenDone"
                             // will called when the I/O completes.
+    void PutBuffer(char *buffer, int size);
+                            // Write "size" characters, and return
+                            // immediately.  "callWhenDone" is called
+                            // once, when the last one has been put.
     void CallBack();        // Invoked when next character can be put
                             // out to the display.
     void PutInt(int n);     // Write n to the console display
@@ -86,6 +103,7 @@ class ConsoleOutput : public CallBackObj {
                                 // the next char can be put
     bool putBusy;               // Is a PutChar operation in progress?
                                 // If so, you can't do another one!
+    int numPutting;             // characters in the operation
 };
 
 #endif  // CONSOLE_H
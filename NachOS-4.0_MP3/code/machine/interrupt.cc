@@ -30,7 +30,10 @@
 static char *intLevelNames[] = {"off", "on"};
 static char *intTypeNames[] = {"timer", "disk", "console write",
                                "console read", "network send",
-                               "network recv"};
+                               "network recv", "network timeout"};
+
+// While threads are running, how often to look for watched input
+const int InputCheckTicks = 10 * TimerTicks;
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -47,11 +50,15 @@ PendingInterrupt::PendingInterrupt(CallBackObj *callOnInt,
     callOnInterrupt = callOnInt;
     when = time;
     type = kind;
+    seq = 0;
 }
 
 //----------------------------------------------------------------------
 // PendingCompare
 //	Compare to interrupts based on which should occur first.
+//	Interrupts due at the same time fire in the order they were
+//	scheduled, as they did when the pending interrupts were kept
+//	on a sorted list.
 //----------------------------------------------------------------------
 
 static int
@@ -60,6 +67,10 @@ PendingCompare(PendingInterrupt *x, PendingInterrupt *y) {
         return -1;
     } else if (x->when > y->when) {
         return 1;
+    } else if (x->seq < y->seq) {
+        return -1;
+    } else if (x->seq > y->seq) {
+        return 1;
     } else {
         return 0;
     }
@@ -74,7 +85,11 @@ PendingCompare(PendingInterrupt *x, PendingInterrupt *y) {
 
 Interrupt::Interrupt() {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    pending = new Heap<PendingInterrupt *>(PendingCompare);
+    numScheduled = 0;
+    numTimersPending = 0;
+    numWatched = 0;
+    lastInputCheck = 0;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -195,18 +210,36 @@ void Interrupt::YieldOnReturn() {
 //	on the ready queue, the only thing to do is to advance
 //	simulated time until the next scheduled hardware interrupt.
 //
-//	If there are no pending interrupts, stop.  There's nothing
-//	more for us to do.
+//	Timer interrupts cannot make a thread ready, so while idle they
+//	are skipped (the timer is "tickless"): the clock jumps straight
+//	to the next device interrupt.  Timer interrupts keep their
+//	phase, so the ones after that still occur when they would have.
+//
+//	If no device interrupt is pending, but a device is waiting for
+//	input from its UNIX file (see WatchInput), the UNIX process
+//	sleeps until the input arrives, rather than spinning.  If the
+//	next device interrupt is a network timeout, it sleeps at most
+//	until the timeout, in real time (see IdleWait).
+//
+//	If there are no pending interrupts other than the timer, stop.
+//	There's nothing more for us to do.
 //----------------------------------------------------------------------
 void Interrupt::Idle() {
     DEBUG(dbgInt, "Machine idling; checking for interrupts.");
     status = IdleMode;
     DEBUG(dbgTraCode, "In Interrupt::Idle, into CheckIfDue, " << kernel->stats->totalTicks);
-    if (CheckIfDue(TRUE)) {  // check for any pending interrupts
-        DEBUG(dbgTraCode, "In Interrupt::Idle, return true from CheckIfDue, " << kernel->stats->totalTicks);
-        status = SystemMode;
-        return;  // return in case there's now
-                 // a runnable thread
+    if (numWatched > 0) {  // wait for input, unless a device
+                           // interrupt is coming anyway
+        CheckInputs(IdleWait());
+    }
+    if (pending->NumInList() > (unsigned int)numTimersPending) {
+        SkipTimers();
+        if (CheckIfDue(TRUE)) {  // check for any pending interrupts
+            DEBUG(dbgTraCode, "In Interrupt::Idle, return true from CheckIfDue, " << kernel->stats->totalTicks);
+            status = SystemMode;
+            return;  // return in case there's now
+                     // a runnable thread
+        }
     }
     DEBUG(dbgTraCode, "In Interrupt::Idle, return false from CheckIfDue, " << kernel->stats->totalTicks);
 
@@ -221,6 +254,114 @@ void Interrupt::Idle() {
     Halt();
 }
 
+//----------------------------------------------------------------------
+// Interrupt::WatchInput
+// 	Arrange for "device" to be interrupted, once, as soon as there is
+//	input to read from UNIX file "fd".  The device calls this again
+//	when it wants more.
+//----------------------------------------------------------------------
+
+void Interrupt::WatchInput(int fd, CallBackObj *device, IntType type) {
+    ASSERT(numWatched < MaxWatchedInputs);
+    DEBUG(dbgInt, "Watching file " << fd << " for the " << intTypeNames[type]);
+    watched[numWatched].fd = fd;
+    watched[numWatched].device = device;
+    watched[numWatched].type = type;
+    numWatched++;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::IdleWait
+// 	Return how many milliseconds Idle should wait for watched input:
+//	forever, if nothing but the timer is pending, and otherwise not
+//	at all -- unless the next device interrupt is a network timeout.
+//	Jumping straight to that would expire the timeout before another
+//	Nachos, running in real time, could possibly have answered; so
+//	wait for the answer as long as the timeout lasts, at
+//	TicksPerMillisecond.
+//----------------------------------------------------------------------
+
+int Interrupt::IdleWait() {
+    List<PendingInterrupt *> timers;
+    PendingInterrupt *next;
+    int wait = 0;
+
+    if (pending->NumInList() == (unsigned int)numTimersPending) {
+        return -1;
+    }
+    while (pending->Front()->type == TimerInt) {  // look past them
+        timers.Append(pending->RemoveFront());
+    }
+    next = pending->Front();
+    if (next->type == NetworkTimeoutInt) {
+        wait = (next->when - kernel->stats->totalTicks) / TicksPerMillisecond;
+    }
+    while (!timers.IsEmpty()) {
+        pending->Insert(timers.RemoveFront());
+    }
+    return wait;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::CheckInputs
+// 	Ask UNIX which watched files can be read, and schedule an
+//	interrupt, on the next tick, for the device of each one; they
+//	are no longer watched.  Return TRUE if there were any.
+//
+//	"timeout" -- how many milliseconds to wait for one to be
+//		readable; -1 means until one is
+//----------------------------------------------------------------------
+
+bool Interrupt::CheckInputs(int timeout) {
+    int fds[MaxWatchedInputs];
+    bool ready[MaxWatchedInputs];
+    int i, numLeft = 0;
+
+    for (i = 0; i < numWatched; i++) {
+        fds[i] = watched[i].fd;
+    }
+    if (WaitForInput(fds, ready, numWatched, timeout) == 0) {
+        return FALSE;
+    }
+    for (i = 0; i < numWatched; i++) {
+        if (ready[i]) {
+            Schedule(watched[i].device, 1, watched[i].type);
+        } else {
+            watched[numLeft++] = watched[i];
+        }
+    }
+    numWatched = numLeft;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::SkipTimers
+// 	Take the timer interrupts off the front of the pending queue,
+//	and move each one forward by whole periods of its timer (as the
+//	timer is set now) until it is no earlier than the first device
+//	interrupt.  There must be a device interrupt pending.
+//----------------------------------------------------------------------
+
+void Interrupt::SkipTimers() {
+    List<PendingInterrupt *> timers;
+    PendingInterrupt *timer;
+    int next, interval, skipped;
+
+    while (pending->Front()->type == TimerInt) {
+        timers.Append(pending->RemoveFront());
+    }
+    next = pending->Front()->when;
+    while (!timers.IsEmpty()) {
+        timer = timers.RemoveFront();
+        // timer interrupts are only scheduled by the Timer device
+        interval = ((Timer *)timer->callOnInterrupt)->GetInterval();
+        skipped = (next - timer->when + interval - 1) / interval;
+        timer->when += skipped * interval;
+        kernel->stats->numTimerSkips += skipped;
+        pending->Insert(timer);
+    }
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Halt
 // 	Shut down Nachos cleanly, printing out performance statistics.
@@ -293,6 +434,10 @@ void Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type) {
     DEBUG(dbgInt, "Scheduling interrupt handler the " << intTypeNames[type] << " at time = " << when);
     ASSERT(fromNow > 0);
 
+    toOccur->seq = numScheduled++;
+    if (type == TimerInt) {
+        numTimersPending++;
+    }
     pending->Insert(toOccur);
 }
 
@@ -342,6 +487,16 @@ bool Interrupt::CheckIfDue(bool advanceClock) {
     inHandler = TRUE;
     do {
         next = pending->RemoveFront();  // pull interrupt off list
+        if (next->type == TimerInt) {
+            numTimersPending--;
+            // look for input while we're at it, but not every time:
+            // each look is a system call
+            if (numWatched > 0 &&
+                stats->totalTicks - lastInputCheck >= InputCheckTicks) {
+                lastInputCheck = stats->totalTicks;
+                CheckInputs(0);
+            }
+        }
         DEBUG(dbgTraCode, "In Interrupt::CheckIfDue, into callOnInterrupt->CallBack, " << stats->totalTicks);
         next->callOnInterrupt->CallBack();  // call the interrupt handler
         DEBUG(dbgTraCode, "In Interrupt::CheckIfDue, return from callOnInterrupt->CallBack, " << stats->totalTicks);
@@ -376,3 +531,87 @@ void Interrupt::DumpState() {
     pending->Apply(PrintPending);
     cout << "\nEnd of pending interrupts\n";
 }
+
+// The following class defines an interrupt used by Interrupt::SelfTest.
+// When it fires, it checks that it fired no earlier than the interrupt
+// before it, and, if they were due at the same time, that it was
+// scheduled after it.
+
+class TestInterrupt : public CallBackObj {
+   public:
+    TestInterrupt(int number, int *lastFired, int *count) {
+        seq = number;
+        last = lastFired;
+        fired = count;
+    }
+
+    void CallBack();
+
+    int seq;  // order in which this interrupt was scheduled
+    int when;  // when it is due
+
+   private:
+    int *last;   // "seq" and "when" of the last interrupt to fire
+    int *fired;  // how many test interrupts have fired
+};
+
+void TestInterrupt::CallBack() {
+    ASSERT(kernel->stats->totalTicks == when);
+    ASSERT(when > last[1] || (when == last[1] && seq > last[0]));
+    last[0] = seq;
+    last[1] = when;
+    (*fired)++;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::SelfTest
+// 	Schedule "numEvents" interrupts a random time into the future,
+//	on a separate copy of the interrupt simulation, then fire them
+//	all off, checking that they fire in the right order.  Print how
+//	long this took in real time.
+//
+//	Simulated time is put back the way it was afterwards.
+//----------------------------------------------------------------------
+
+void Interrupt::SelfTest(int numEvents) {
+    Interrupt *test = new Interrupt();
+    TestInterrupt **events = new TestInterrupt *[numEvents];
+    Statistics *stats = kernel->stats;
+    int oldTotalTicks = stats->totalTicks;
+    int oldIdleTicks = stats->idleTicks;
+    int last[2] = {-1, -1};
+    int fired = 0;
+    double start, scheduled, finish;
+    int i;
+
+    for (i = 0; i < numEvents; i++) {
+        events[i] = new TestInterrupt(i, last, &fired);
+    }
+
+    start = HostTime();
+    for (i = 0; i < numEvents; i++) {
+        int fromNow = 1 + RandomNumber() % (numEvents / 4 + 1);
+
+        events[i]->when = stats->totalTicks + fromNow;
+        test->Schedule(events[i], fromNow, TimerInt);
+    }
+    scheduled = HostTime();
+    while (test->CheckIfDue(TRUE)) {
+    }
+    finish = HostTime();
+    ASSERT(fired == numEvents && test->pending->IsEmpty());
+
+    cout << "Interrupt self test: " << numEvents << " interrupts, "
+         << (scheduled - start) * 1000000.0 / numEvents
+         << " us to schedule, "
+         << (finish - scheduled) * 1000000.0 / numEvents
+         << " us to fire, per interrupt\n";
+
+    stats->totalTicks = oldTotalTicks;
+    stats->idleTicks = oldIdleTicks;
+    for (i = 0; i < numEvents; i++) {
+        delete events[i];
+    }
+    delete[] events;
+    delete test;
+}
@@ -35,7 +35,7 @@
 
 #include "callback.h"
 #include "copyright.h"
-#include "list.h"
+#include "heap.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff,
@@ -50,13 +50,30 @@ enum MachineStatus { IdleMode,
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network.  A network timeout is a timer
+// that a network protocol sets while it waits for another machine.
 enum IntType { TimerInt,
                DiskInt,
                ConsoleWriteInt,
                ConsoleReadInt,
                NetworkSendInt,
-               NetworkRecvInt };
+               NetworkRecvInt,
+               NetworkTimeoutInt };
+
+// The following class records a device that wants an interrupt when
+// its UNIX file (say, the keyboard) has input to be read.  Watching
+// the file costs next to nothing until then: Nachos waits for it when
+// there is nothing else to do, and otherwise only checks it now and
+// then (every InputCheckTicks), when the timer goes off.
+
+class WatchedInput {
+   public:
+    int fd;                   // UNIX file the input comes from
+    CallBackObj *device;      // whom to interrupt when it can be read
+    IntType type;             // for debugging
+};
+
+const int MaxWatchedInputs = 8;  // most files watched at once
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -75,6 +92,8 @@ class PendingInterrupt {
 
     int when;      // When the interrupt is supposed to fire
     IntType type;  // for debugging
+    int seq;       // Order in which the interrupt was scheduled;
+                   // interrupts due at the same time fire in this order
 };
 
 // The following class defines the data structures for the simulation
@@ -120,6 +139,9 @@ class Interrupt {
 
     void DumpState();  // Print interrupt state
 
+    void SelfTest(int numEvents);  // time scheduling and firing
+                                   // "numEvents" interrupts
+
     // NOTE: the following are internal to the hardware simulation code.
     // DO NOT call these directly.  I should make them "private",
     // but they need to be public since they are called by the
@@ -132,11 +154,22 @@ class Interrupt {
 
     void OneTick();  // Advance simulated time
 
+    void WatchInput(int fd, CallBackObj *device, IntType type);
+    // Interrupt "device" once, as soon
+    // as UNIX file "fd" can be read
+
    private:
     IntStatus level;  // are interrupts enabled or disabled?
-    SortedList<PendingInterrupt *> *pending;
-    // the list of interrupts scheduled
-    // to occur in the future
+    Heap<PendingInterrupt *> *pending;
+    // the interrupts scheduled to occur
+    // in the future, soonest first
+    int numScheduled;  // interrupts scheduled so far, to
+                       // number them in order
+    int numTimersPending;  // how many of the pending interrupts
+                           // are timer interrupts
+    WatchedInput watched[MaxWatchedInputs];
+    int numWatched;        // files being watched for input
+    int lastInputCheck;    // when we last looked for input
     // int writeFileNo;            //UNIX file emulating the display
     bool inHandler;  // TRUE if we are running an interrupt handler
     // bool putBusy;               // Is a PrintInt operation in progress
@@ -151,6 +184,17 @@ class Interrupt {
     // Check if any interrupts are supposed
     // to occur now, and if so, do them
 
+    bool CheckInputs(int timeout);
+    // Interrupt the devices whose input
+    // has arrived; wait up to "timeout" ms
+    // for some (-1 means forever)
+
+    int IdleWait();  // How long Idle should wait for input
+
+    void SkipTimers();  // Push back the timer interrupts that
+                        // would occur before the next device
+                        // interrupt
+
     void ChangeLevel(IntStatus old,   // SetLevel, without advancing the
                      IntStatus now);  // simulated time
 };
@@ -33,9 +33,13 @@ const int PageSize = 128;  // set the page size equal to
 //
 // You are allowed to change this value.
 // Doing so will change the number of pages of physical memory
-// available on the simulated machine.
+// available on the simulated machine.  It can also be set at
+// compile time by adding "-DNUM_PHYS_PAGES=n" to the DEFINES.
 //
-const int NumPhysPages = 128;
+#ifndef NUM_PHYS_PAGES
+#define NUM_PHYS_PAGES 128
+#endif
+const int NumPhysPages = NUM_PHYS_PAGES;
 
 const int MemorySize = (NumPhysPages * PageSize);
 const int TLBSize = 4;  // if there is a TLB, make it small
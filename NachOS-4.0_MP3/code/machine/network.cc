@@ -13,6 +13,31 @@
 #include "copyright.h"
 #include "main.h"
 
+static char *packetPool[PacketPoolSize];
+static int numPooledPackets = 0;
+
+//-----------------------------------------------------------------------
+// AllocPacket, FreePacket
+// 	Get a buffer big enough for any packet, from the pool if there
+//	is one there; and give one back.
+//-----------------------------------------------------------------------
+
+char *
+AllocPacket() {
+    if (numPooledPackets > 0) {
+        return packetPool[--numPooledPackets];
+    }
+    return new char[MaxWireSize];
+}
+
+void FreePacket(char *packet) {
+    if (numPooledPackets < PacketPoolSize) {
+        packetPool[numPooledPackets++] = packet;
+    } else {
+        delete[] packet;
+    }
+}
+
 //-----------------------------------------------------------------------
 // NetworkInput::NetworkInput
 // 	Initialize the simulation for the network input
@@ -23,16 +48,18 @@
 NetworkInput::NetworkInput(CallBackObj *toCall) {
     // set up the stuff to emulate asynchronous interrupts
     callWhenAvail = toCall;
-    packetAvail = FALSE;
-    inHdr.length = 0;
+    ringSize = kernel->networkRing;
+    ASSERT(ringSize > 0);
+    ring = new char *[ringSize];
+    head = numInRing = 0;
 
     sock = OpenSocket();
     sprintf(sockName, "SOCKET_%d", kernel->hostName);
     AssignNameToSocket(sockName, sock);  // Bind socket to a filename
                                          // in the current directory.
 
-    // start polling for incoming packets
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    // start waiting for incoming packets
+    Watch();
 }
 
 //-----------------------------------------------------------------------
@@ -44,6 +71,21 @@ NetworkInput::NetworkInput(CallBackObj *toCall) {
 NetworkInput::~NetworkInput() {
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
+    // ReceivePacket would ask for more input; just drop what is left
+    for (int i = 0; i < numInRing; i++) {
+        FreePacket(ring[(head + i) % ringSize]);
+    }
+    delete[] ring;
+}
+
+//-----------------------------------------------------------------------
+// NetworkInput::Watch
+//	Ask to be interrupted as soon as the socket has packets to read.
+//-----------------------------------------------------------------------
+
+void NetworkInput::Watch() {
+    watching = TRUE;
+    kernel->interrupt->WatchInput(sock, this, NetworkRecvInt);
 }
 
 //-----------------------------------------------------------------------
@@ -51,50 +93,80 @@ NetworkInput::~NetworkInput() {
 //	Simulator calls this when a packet may be available to
 //	be read in from the simulated network.
 //
-//      First check to make sure packet is available & there's space to
-//	pull it in.  Then invoke the "callBack" registered by whoever
-//	wants the packet.
+//      Pull in as many packets as are waiting and there are free
+//	slots for, then invoke the "callBack" registered by whoever
+//	wants the packets -- once, for the whole batch.  If the ring
+//	fills up, stop watching the socket until Receive makes room.
 //-----------------------------------------------------------------------
 
 void NetworkInput::CallBack() {
-    // schedule the next time to poll for a packet
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
-
-    if (inHdr.length != 0)  // do nothing if packet is already buffered
-        return;
-    if (!PollSocket(sock))  // do nothing if no packet to be read
+    int numArrived = 0;
+
+    watching = FALSE;
+    while (numInRing < ringSize && PollSocket(sock)) {
+        char *buffer = AllocPacket();
+        PacketHeader *hdr = (PacketHeader *)buffer;
+
+        ReadFromSocket(sock, buffer, MaxWireSize);
+        ring[(head + numInRing) % ringSize] = buffer;
+        ASSERT((hdr->to == kernel->hostName) && (hdr->length <= MaxPacketSize));
+        DEBUG(dbgNet, "Network received packet from " << hdr->from << ", length " << hdr->length);
+        numInRing++;
+        numArrived++;
+    }
+    if (numInRing < ringSize) {
+        Watch();  // wait for the next packets
+    }
+    if (numArrived == 0) {
         return;
+    }
+    kernel->stats->numPacketsRecvd += numArrived;
+    kernel->stats->numNetworkInterrupts++;
 
-    // otherwise, read packet in
-    char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+    // tell post office that the packets have arrived
+    callWhenAvail->CallBack();
+}
 
-    // divide packet into header and data
-    inHdr = *(PacketHeader *)buffer;
-    ASSERT((inHdr.to == kernel->hostName) && (inHdr.length <= MaxPacketSize));
-    bcopy(buffer + sizeof(PacketHeader), inbox, inHdr.length);
-    delete[] buffer;
+//-----------------------------------------------------------------------
+// NetworkInput::ReceivePacket
+// 	Take the oldest packet, if one is buffered, off the ring, and
+//	return the buffer holding it; the caller now owns the buffer.
+//-----------------------------------------------------------------------
 
-    DEBUG(dbgNet, "Network received packet from " << inHdr.from << ", length " << inHdr.length);
-    kernel->stats->numPacketsRecvd++;
+char *
+NetworkInput::ReceivePacket() {
+    char *packet;
 
-    // tell post office that the packet has arrived
-    callWhenAvail->CallBack();
+    if (numInRing == 0) {
+        return NULL;
+    }
+    packet = ring[head];
+    head = (head + 1) % ringSize;
+    numInRing--;
+    if (!watching) {  // the ring was full; there's room again
+        Watch();
+    }
+    return packet;
 }
 
 //-----------------------------------------------------------------------
 // NetworkInput::Receive
-// 	Read a packet, if one is buffered
+// 	Read the oldest packet, if one is buffered, into "data"
 //-----------------------------------------------------------------------
 
 PacketHeader
 NetworkInput::Receive(char *data) {
-    PacketHeader hdr = inHdr;
+    char *packet = ReceivePacket();
+    PacketHeader hdr;
 
-    inHdr.length = 0;
-    if (hdr.length != 0) {
-        bcopy(inbox, data, hdr.length);
+    if (packet == NULL) {
+        hdr.length = 0;
+        return hdr;
     }
+    hdr = *(PacketHeader *)packet;
+    bcopy(packet + sizeof(PacketHeader), data, hdr.length);
+    kernel->stats->numMailBytesCopied += hdr.length;
+    FreePacket(packet);
     return hdr;
 }
 
@@ -116,7 +188,9 @@ NetworkOutput::NetworkOutput(double reliability, CallBackObj *toCall) {
 
     // set up the stuff to emulate asynchronous interrupts
     callWhenDone = toCall;
-    sendBusy = FALSE;
+    ringSize = kernel->networkRing;
+    ASSERT(ringSize > 0);
+    numInFlight = numDone = 0;
     sock = OpenSocket();
 }
 
@@ -131,20 +205,37 @@ NetworkOutput::~NetworkOutput() {
 
 //-----------------------------------------------------------------------
 // NetworkOutput::CallBack
-// 	Called by simulator when another packet can be sent.
+// 	Called by simulator when a batch of packets has been sent, and
+//	their slots can be used again.
 //-----------------------------------------------------------------------
 
 void NetworkOutput::CallBack() {
-    sendBusy = FALSE;
-    kernel->stats->numPacketsSent++;
+    kernel->stats->numPacketsSent += numInFlight;
+    kernel->stats->numNetworkInterrupts++;
+    numDone += numInFlight;
+    numInFlight = 0;
     callWhenDone->CallBack();
 }
 
+//-----------------------------------------------------------------------
+// NetworkOutput::Reclaim
+// 	Return the number of packets sent since the last call; their
+//	slots are free again.
+//-----------------------------------------------------------------------
+
+int NetworkOutput::Reclaim() {
+    int n = numDone;
+
+    numDone = 0;
+    return n;
+}
+
 //-----------------------------------------------------------------------
 // NetworkOutput::Send
 // 	Send a packet into the simulated network, to the destination in hdr.
-// 	Concatenate hdr and data, and schedule an interrupt to tell the user
-// 	when the next packet can be sent
+// 	Concatenate hdr and data, and, unless one is already coming for
+//	an earlier packet, schedule an interrupt to tell the user when
+//	the batch has been sent
 //
 // 	Note we always pad out a packet to MaxWireSize before putting it into
 // 	the socket, because it's simpler at the receive end.
@@ -155,11 +246,14 @@ void NetworkOutput::Send(PacketHeader hdr, char *data) {
 
     sprintf(toName, "SOCKET_%d", (int)hdr.to);
 
-    ASSERT((sendBusy == FALSE) && (hdr.length > 0) &&
+    ASSERT((numInFlight + numDone < ringSize) && (hdr.length > 0) &&
            (hdr.length <= MaxPacketSize) && (hdr.from == kernel->hostName));
     DEBUG(dbgNet, "Sending to addr " << hdr.to << ", length " << hdr.length);
 
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkSendInt);
+    if (numInFlight == 0) {  // first packet of a batch
+        kernel->interrupt->Schedule(this, NetworkTime, NetworkSendInt);
+    }
+    numInFlight++;
 
     if (RandomNumber() % 100 >= chanceToWork * 100) {  // emulate a lost packet
         DEBUG(dbgNet, "oops, lost it!");
@@ -42,10 +42,27 @@ class PacketHeader {
 #define MaxPacketSize (MaxWireSize - sizeof(struct PacketHeader))
 // data "payload" of the largest packet
 
+// Arriving packets are read off the wire into buffers of MaxWireSize
+// bytes, header and all, and the buffer itself is handed to whoever
+// takes the packet, rather than a copy.  Buffers that are given back
+// are kept for the next packets, rather than returned to the heap.
+
+const int PacketPoolSize = 64;  // most free buffers kept
+
+extern char *AllocPacket();            // Get a buffer for a packet
+extern void FreePacket(char *packet);  // Give it back
+
 // The following two classes defines a physical network device.  The network
 // is capable of delivering fixed sized packets, in order but unreliably,
 // to other machines connected to the network.
 //
+// Each direction of the device has a ring of "kernel->networkRing"
+// packet slots (see "-ring"), so that several packets can be in flight
+// at once, and it interrupts once per batch of packets rather than
+// once per packet: the input side as soon as packets arrive, with all
+// the packets that have arrived; the output side NetworkTime after
+// the first packet of a batch is sent, for every packet sent so far.
+//
 // The "reliability" of the network can be specified to the constructor.
 // This number, between 0 and 1, is the chance that the network will lose
 // a packet.  Note that you can change the seed for the random number
@@ -61,22 +78,31 @@ class NetworkInput : public CallBackObj {
     PacketHeader Receive(char *data);
     // Poll the network for incoming messages.
     // If there is a packet waiting, copy the
-    // packet into "data" and return the header.
-    // If no packet is waiting, return a header
-    // with length 0.
+    // oldest packet into "data" and return the
+    // header.  If no packet is waiting, return
+    // a header with length 0.
+    char *ReceivePacket();
+    // Same, but return the buffer holding the
+    // oldest packet, header first, without
+    // copying it, or NULL if none is waiting.
+    // The caller must FreePacket it.
 
-    void CallBack();  // A packet may have arrived.
+    void CallBack();  // Packets may have arrived.
 
    private:
     int sock;           // UNIX socket number for incoming packets
     char sockName[32];  // File name corresponding to UNIX socket
 
-    CallBackObj *callWhenAvail;  // Interrupt handler, signalling packet has
-                                 // 	arrived.
-    bool packetAvail;            // Packet has arrived, can be pulled off of
-                                 //   network
-    PacketHeader inHdr;          // Information about arrived packet
-    char inbox[MaxPacketSize];   // Data for arrived packet
+    CallBackObj *callWhenAvail;  // Interrupt handler, signalling packets
+                                 // 	have arrived.
+    char **ring;                 // Buffers holding the arrived packets,
+                                 //   as they came off the wire
+    int ringSize;                // Number of slots in "ring"
+    int head;                    // Slot of the oldest arrived packet
+    int numInRing;               // Number of arrived packets
+    bool watching;               // Waiting for the socket to be readable?
+
+    void Watch();  // Wait for packets to arrive
 };
 
 class NetworkOutput : public CallBackObj {
@@ -88,22 +114,28 @@ class NetworkOutput : public CallBackObj {
     void Send(PacketHeader hdr, char *data);
     // Send the packet data to a remote machine,
     // specified by "hdr".  Returns immediately.
-    // "callWhenDone" is invoked once the next
-    // packet can be sent.  Note that callWhenDone
-    // is called whether or not the packet is
-    // dropped, and note that the "from" field of
-    // the PacketHeader is filled in automatically
-    // by Send().
-
-    void CallBack();  // Interrupt handler, called when message is
-                      // sent
+    // There must be a free slot in the ring.
+    // "callWhenDone" is invoked once the packet
+    // is done with and its slot is free again.
+    // Note that callWhenDone is called whether
+    // or not the packet is dropped, and note that
+    // the "from" field of the PacketHeader is
+    // filled in automatically by Send().
+    int RingSize() { return ringSize; }
+    int Reclaim();  // Return how many slots have been
+                    // freed since the last call
+
+    void CallBack();  // Interrupt handler, called when a batch of
+                      // packets has been sent
 
    private:
     int sock;                   // UNIX socket number for outgoing packets
     double chanceToWork;        // Likelihood packet will be dropped
-    CallBackObj *callWhenDone;  // Interrupt handler, signalling next packet
+    CallBackObj *callWhenDone;  // Interrupt handler, signalling packets
                                 //      can be sent.
-    bool sendBusy;              // Packet is being sent.
+    int ringSize;               // Number of packets that can be in flight
+    int numInFlight;            // Packets being sent
+    int numDone;                // Packets sent, not yet reclaimed
 };
 
 #endif  // NETWORK_H
@@ -21,7 +21,20 @@ Statistics::Statistics() {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
-    numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPageFaults = numPageOuts = numPacketsSent = numPacketsRecvd = 0;
+    numNetworkInterrupts = numSegmentsSent = numSegmentsResent = 0;
+    numMailReceived = numMailBytesCopied = 0;
+    numCPUs = 1;
+    for (int i = 0; i < MaxCPUs; i++) {
+        cpuBusyTicks[i] = 0;
+    }
+    numSteals = 0;
+    numContextSwitches = numThreadsFinished = numTimerSkips = 0;
+    numTimerInterrupts = 0;
+    for (int i = 0; i <= NumLevels; i++) {
+        numPreemptions[i] = 0;
+    }
+    totalTurnaround = totalWaiting = 0;
 }
 
 //----------------------------------------------------------------------
@@ -33,11 +46,58 @@ Statistics::Statistics() {
 void Statistics::Print() {
     cout << "Ticks: total " << totalTicks << ", idle " << idleTicks;
     cout << ", system " << systemTicks << ", user " << userTicks << "\n";
+    cout << "Timer: interrupts " << numTimerInterrupts;
+    cout << ", skipped while idle " << numTimerSkips << "\n";
     cout << "Disk I/O: reads " << numDiskReads;
     cout << ", writes " << numDiskWrites << "\n";
     cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
-    cout << "Paging: faults " << numPageFaults << "\n";
+    cout << "Paging: faults " << numPageFaults;
+    cout << ", page outs " << numPageOuts << "\n";
     cout << "Network I/O: packets received " << numPacketsRecvd;
-    cout << ", sent " << numPacketsSent << "\n";
+    cout << ", sent " << numPacketsSent;
+    cout << ", interrupts " << numNetworkInterrupts << "\n";
+    if (numMailReceived > 0) {
+        cout << "Mail: messages received " << numMailReceived;
+        cout << ", bytes copied " << numMailBytesCopied << " (";
+        cout << numMailBytesCopied / numMailReceived << " per message)\n";
+    }
+    if (numSegmentsSent > 0) {
+        cout << "Transport: segments sent " << numSegmentsSent;
+        cout << ", retransmitted " << numSegmentsResent << "\n";
+    }
+    if (numCPUs > 1) {
+        for (int i = 0; i < numCPUs; i++) {
+            cout << "CPU " << i << ": busy " << cpuBusyTicks[i];
+            cout << " ticks, utilization ";
+            cout << (totalTicks > 0 ? (int)(100.0 * cpuBusyTicks[i] / totalTicks) : 0);
+            cout << "%\n";
+        }
+        cout << "Work stealing: threads stolen " << numSteals << "\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintScheduling
+// 	Print how well the threads were scheduled: the average time
+//	from fork to finish, the average time spent waiting on the
+//	ready queue, the number of context switches, and how often the
+//	timer went off and preempted a thread at each level.
+//----------------------------------------------------------------------
+
+void Statistics::PrintScheduling() {
+    int n = (numThreadsFinished > 0) ? numThreadsFinished : 1;
+
+    cout << "Scheduling: threads finished " << numThreadsFinished;
+    cout << ", average turnaround " << totalTurnaround / n;
+    cout << ", average waiting " << totalWaiting / n;
+    cout << ", context switches " << numContextSwitches << "\n";
+    cout << "Preemptions: timer interrupts " << numTimerInterrupts;
+    if (numPreemptions[0] > 0) {
+        cout << ", preempted " << numPreemptions[0];
+    }
+    for (int i = 1; i <= NumLevels; i++) {
+        cout << ", L" << i << " " << numPreemptions[i];
+    }
+    cout << "\n";
 }
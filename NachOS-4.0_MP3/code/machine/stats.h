@@ -13,6 +13,9 @@
 
 #include "copyright.h"
 
+const int MaxCPUs = 8;  // most CPUs the scheduler can simulate
+const int NumLevels = 3;  // levels of the multi-level feedback queue
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -33,12 +36,33 @@ class Statistics {
     int numConsoleCharsRead;     // number of characters read from the keyboard
     int numConsoleCharsWritten;  // number of characters written to the display
     int numPageFaults;           // number of virtual memory page faults
+    int numPageOuts;             // number of pages written to swap
     int numPacketsSent;          // number of packets sent over the network
     int numPacketsRecvd;         // number of packets received over the network
+    int numNetworkInterrupts;    // number of network interrupts, each for
+                                 // a batch of packets
+    int numMailReceived;         // number of messages delivered to mailboxes
+    int numMailBytesCopied;      // bytes copied on their way from the wire
+                                 // to the receiver
+    int numSegmentsSent;         // number of transport segments sent
+    int numSegmentsResent;       // of which were retransmissions
+    int numCPUs;                 // number of CPUs simulated
+    int cpuBusyTicks[MaxCPUs];   // ticks each CPU had work to do
+    int numSteals;               // threads moved to an idle CPU
+    int numContextSwitches;      // number of context switches
+    int numTimerInterrupts;      // number of timer interrupts
+    int numTimerSkips;           // timer interrupts skipped while idle
+    int numPreemptions[NumLevels + 1];  // threads preempted at each
+                                        // MLFQ level (level 0 for
+                                        // policies without levels)
+    int numThreadsFinished;      // number of threads that have finished
+    int totalTurnaround;         // sum of their times from fork to finish
+    int totalWaiting;            // sum of their times on the ready queue
 
     Statistics();  // initialize everything to zero
 
     void Print();  // print collected statistics
+    void PrintScheduling();  // print scheduling statistics only
 };
 
 // Constants used to reflect the relative time an operation would
@@ -56,5 +80,7 @@ const int SeekTime = 500;      // time disk takes to seek past one track
 const int ConsoleTime = 1;   // time to read or write one character
 const int NetworkTime = 100;   // time to send or receive one packet
 const int TimerTicks = 100;    // (average) time between timer interrupts
+const int TicksPerMillisecond = 100;  // how fast time passes while
+                                      // waiting for another machine
 
 #endif  // STATS_H
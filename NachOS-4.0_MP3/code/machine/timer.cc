@@ -40,6 +40,7 @@ Timer::Timer(bool doRandom, CallBackObj *toCall) {
     randomize = doRandom;
     callPeriodically = toCall;
     disable = FALSE;
+    interval = TimerTicks;
     SetInterrupt();
 }
 
@@ -66,10 +67,10 @@ void Timer::CallBack() {
 
 void Timer::SetInterrupt() {
     if (!disable) {
-        int delay = TimerTicks;
+        int delay = interval;
 
         if (randomize) {
-            delay = 1 + (RandomNumber() % (TimerTicks * 2));
+            delay = 1 + (RandomNumber() % (interval * 2));
         }
         // schedule the next timer device interrupt
         kernel->interrupt->Schedule(this, delay, TimerInt);
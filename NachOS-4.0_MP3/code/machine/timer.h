@@ -36,9 +36,17 @@ class Timer : public CallBackObj {
     // Turn timer device off, so it doesn't
     // generate any more interrupts.
 
+    void SetInterval(int ticks) { interval = ticks; }
+    int GetInterval() { return interval; }
+    // Change how long it is from one
+    // interrupt to the next (on average,
+    // if the delay is random)
+
    private:
     bool randomize;                 // set if we need to use a random timeout delay
-    CallBackObj *callPeriodically;  // call this every TimerTicks time units
+    CallBackObj *callPeriodically;  // call this every "interval" time units
+    int interval;                   // time between interrupts, TimerTicks
+                                    // unless changed
     bool disable;                   // turn off the timer device after next
                                     // interrupt.
 
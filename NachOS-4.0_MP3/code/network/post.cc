@@ -22,20 +22,29 @@
 
 //----------------------------------------------------------------------
 // Mail::Mail
-//      Initialize a single mail message, by concatenating the headers to
-//	the data.
+//      Initialize a single mail message, from the packet buffer it
+//	arrived in.  The headers are picked out of the front of the
+//	packet; the data is left where it is.
 //
-//	"pktH" -- source, destination machine ID's
-//	"mailH" -- source, destination mailbox ID's
-//	"data" -- payload data
+//	"packet" -- the packet, as it came off the wire; the Mail
+//		owns it from now on
 //----------------------------------------------------------------------
 
-Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData) {
-    ASSERT(mailH.length <= MaxMailSize);
+Mail::Mail(char *packet) {
+    this->packet = packet;
+    pktHdr = *(PacketHeader *)packet;
+    mailHdr = *(MailHeader *)(packet + sizeof(PacketHeader));
+    data = packet + sizeof(PacketHeader) + sizeof(MailHeader);
+    ASSERT(mailHdr.length <= MaxMailSize);
+}
+
+//----------------------------------------------------------------------
+// Mail::~Mail
+//      Give the packet buffer back to the network.
+//----------------------------------------------------------------------
 
-    pktHdr = pktH;
-    mailHdr = mailH;
-    bcopy(msgData, data, mailHdr.length);
+Mail::~Mail() {
+    FreePacket(packet);
 }
 
 //----------------------------------------------------------------------
@@ -81,22 +90,37 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr) {
 // 	Add a message to the mailbox.  If anyone is waiting for message
 //	arrival, wake them up!
 //
-//	We need to reconstruct the Mail message (by concatenating the headers
-//	to the data), to simplify queueing the message on the SynchList.
-//
-//	"pktHdr" -- source, destination machine ID's
-//	"mailHdr" -- source, destination mailbox ID's
-//	"data" -- payload message data
+//	"mail" -- the message; the mailbox owns it until it is taken out
 //----------------------------------------------------------------------
 
-void MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data) {
-    Mail *mail = new Mail(pktHdr, mailHdr, data);
-
+void MailBox::Put(Mail *mail) {
+    kernel->stats->numMailReceived++;
     messages->Append(mail);  // put on the end of the list of
                              // arrived messages, and wake up
                              // any waiters
 }
 
+//----------------------------------------------------------------------
+// MailBox::Get
+// 	Take a message out of a mailbox, and hand it to the caller, who
+//	is to delete it once done with it.
+//
+//	The calling thread waits if there are no messages in the mailbox.
+//----------------------------------------------------------------------
+
+Mail *
+MailBox::Get() {
+    DEBUG(dbgNet, "Waiting for mail in mailbox");
+    Mail *mail = messages->RemoveFront();  // remove message from list;
+                                           // will wait if list is empty
+
+    if (debug->IsEnabled('n')) {
+        cout << "Got mail from mailbox: ";
+        PrintHeader(mail->pktHdr, mail->mailHdr);
+    }
+    return mail;
+}
+
 //----------------------------------------------------------------------
 // MailBox::Get
 // 	Get a message from a mailbox, parsing it into the packet header,
@@ -110,19 +134,14 @@ void MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data) {
 //----------------------------------------------------------------------
 
 void MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) {
-    DEBUG(dbgNet, "Waiting for mail in mailbox");
-    Mail *mail = messages->RemoveFront();  // remove message from list;
-                                           // will wait if list is empty
+    Mail *mail = Get();
 
     *pktHdr = mail->pktHdr;
     *mailHdr = mail->mailHdr;
-    if (debug->IsEnabled('n')) {
-        cout << "Got mail from mailbox: ";
-        PrintHeader(*pktHdr, *mailHdr);
-    }
     bcopy(mail->data, data, mail->mailHdr.length);
     // copy the message data into
     // the caller's buffer
+    kernel->stats->numMailBytesCopied += mail->mailHdr.length;
     delete mail;  // we've copied out the stuff we
                   // need, we can now discard the message
 }
@@ -172,33 +191,35 @@ PostOfficeInput::~PostOfficeInput() {
 // PostOffice::PostalDelivery
 // 	Wait for incoming messages, and put them in the right mailbox.
 //
-//      Incoming messages have had the PacketHeader stripped off,
-//	but the MailHeader is still tacked on the front of the data.
+//      Incoming messages still have the PacketHeader and the MailHeader
+//	on the front of the data, just as they came off the wire; the
+//	packet buffer itself goes into the mailbox.
+//
+//	The network interrupts once for a whole batch of packets, so
+//	each time we are woken up, deliver everything that has arrived.
 //----------------------------------------------------------------------
 
 void PostOfficeInput::PostalDelivery(void *data) {
     PostOfficeInput *_this = (PostOfficeInput *)data;
-    PacketHeader pktHdr;
-    MailHeader mailHdr;
-    char *buffer = new char[MaxPacketSize];
+    char *packet;
+    Mail *mail;
 
     for (;;) {
-        // first, wait for a message
+        // first, wait for messages
         _this->messageAvailable->P();
-        pktHdr = _this->network->Receive(buffer);
-
-        mailHdr = *(MailHeader *)buffer;
-        if (debug->IsEnabled('n')) {
-            cout << "Putting mail into mailbox: ";
-            PrintHeader(pktHdr, mailHdr);
+        while ((packet = _this->network->ReceivePacket()) != NULL) {
+            mail = new Mail(packet);
+            if (debug->IsEnabled('n')) {
+                cout << "Putting mail into mailbox: ";
+                PrintHeader(mail->pktHdr, mail->mailHdr);
+            }
+
+            // check that arriving message is legal!
+            ASSERT(0 <= mail->mailHdr.to && mail->mailHdr.to < _this->numBoxes);
+
+            // put into mailbox
+            _this->boxes[mail->mailHdr.to].Put(mail);
         }
-
-        // check that arriving message is legal!
-        ASSERT(0 <= mailHdr.to && mailHdr.to < _this->numBoxes);
-        ASSERT(mailHdr.length <= MaxMailSize);
-
-        // put into mailbox
-        _this->boxes[mailHdr.to].Put(pktHdr, mailHdr, buffer + sizeof(MailHeader));
     }
 }
 
@@ -225,6 +246,13 @@ void PostOfficeInput::Receive(int box, PacketHeader *pktHdr,
     ASSERT(mailHdr->length <= MaxMailSize);
 }
 
+Mail *
+PostOfficeInput::Receive(int box) {
+    ASSERT((box >= 0) && (box < numBoxes));
+
+    return boxes[box].Get();
+}
+
 //----------------------------------------------------------------------
 // PostOffice::CallBack
 // 	Interrupt handler, called when a packet arrives from the network.
@@ -244,13 +272,14 @@ void PostOfficeInput::CallBack() {
 //	  be delivered (e.g., reliability = 1 means the network never
 //	  drops any packets; reliability = 0 means the network never
 //	  delivers any packets)
+//
+//	As many messages can be in flight as the network has room for
+//	in its send ring.
 //----------------------------------------------------------------------
 
 PostOfficeOutput::PostOfficeOutput(double reliability) {
-    messageSent = new Semaphore("message sent", 0);
-    sendLock = new Lock("message send lock");
-
     network = new NetworkOutput(reliability, this);
+    slotsFree = new Semaphore("send ring slots", network->RingSize());
 }
 
 //----------------------------------------------------------------------
@@ -260,8 +289,7 @@ PostOfficeOutput::PostOfficeOutput(double reliability) {
 
 PostOfficeOutput::~PostOfficeOutput() {
     delete network;
-    delete messageSent;
-    delete sendLock;
+    delete slotsFree;
 }
 
 //----------------------------------------------------------------------
@@ -278,8 +306,8 @@ PostOfficeOutput::~PostOfficeOutput() {
 //----------------------------------------------------------------------
 
 void PostOfficeOutput::Send(PacketHeader pktHdr, MailHeader mailHdr, char *data) {
-    char *buffer = new char[MaxPacketSize];  // space to hold concatenated
-                                             // mailHdr + data
+    char *buffer = AllocPacket();  // space to hold concatenated
+                                   // mailHdr + data
 
     if (debug->IsEnabled('n')) {
         cout << "Post send: ";
@@ -296,25 +324,25 @@ void PostOfficeOutput::Send(PacketHeader pktHdr, MailHeader mailHdr, char *data)
     bcopy((char *)&mailHdr, buffer, sizeof(MailHeader));
     bcopy(data, buffer + sizeof(MailHeader), mailHdr.length);
 
-    sendLock->Acquire();  // only one message can be sent
-                          // to the network at any one time
+    slotsFree->P();  // wait for room in the send ring; the
+                     // message goes out without waiting for
+                     // the ones ahead of it to finish
     network->Send(pktHdr, buffer);
-    messageSent->P();  // wait for interrupt to tell us
-                       // ok to send the next message
-    sendLock->Release();
 
-    delete[] buffer;  // we've sent the message, so
-                      // we can delete our buffer
+    FreePacket(buffer);  // the network has copied the message,
+                         // so we can give back our buffer
 }
 
 //----------------------------------------------------------------------
 // PostOfficeOutput::CallBack
-// 	Interrupt handler, called when the next packet can be put onto the
-//	network.
+// 	Interrupt handler, called when a batch of packets has been put
+//	onto the network, and their ring slots can be used again.
 //
-//	Called even if the previous packet was dropped.
+//	Called even if some of the packets were dropped.
 //----------------------------------------------------------------------
 
 void PostOfficeOutput::CallBack() {
-    messageSent->V();
+    for (int n = network->Reclaim(); n > 0; n--) {
+        slotsFree->V();
+    }
 }
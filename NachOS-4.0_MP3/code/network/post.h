@@ -55,21 +55,29 @@ class MailHeader {
 
 #define MaxMailSize (MaxPacketSize - sizeof(MailHeader))
 
-// The following class defines the format of an incoming/outgoing
+// The following class defines the format of an incoming
 // "Mail" message.  The message format is layered:
 //	network header (PacketHeader)
 //	post office header (MailHeader)
 //	data
+//
+// A Mail is just the packet buffer it arrived in, exactly as it came
+// off the wire: the message is never copied on its way from the
+// network to the mailbox.  The buffer goes back to the network's
+// pool when the Mail is deleted.
 
 class Mail {
    public:
-    Mail(PacketHeader pktH, MailHeader mailH, char *msgData);
-    // Initialize a mail message by
-    // concatenating the headers to the data
+    Mail(char *packet);  // Take over a packet buffer
+                         // from the network
+    ~Mail();             // Give the buffer back
+
+    PacketHeader pktHdr;  // Header appended by Network
+    MailHeader mailHdr;   // Header appended by PostOffice
+    char *data;           // Payload -- message data, in "packet"
 
-    PacketHeader pktHdr;     // Header appended by Network
-    MailHeader mailHdr;      // Header appended by PostOffice
-    char data[MaxMailSize];  // Payload -- message data
+   private:
+    char *packet;  // Buffer holding the whole packet
 };
 
 // The following class defines a single mailbox, or temporary storage
@@ -82,12 +90,12 @@ class MailBox {
     MailBox();   // Allocate and initialize mail box
     ~MailBox();  // De-allocate mail box
 
-    void Put(PacketHeader pktHdr, MailHeader mailHdr, char *data);
-    // Atomically put a message into the mailbox
+    void Put(Mail *mail);  // Atomically put a message into the mailbox
+    Mail *Get();           // Atomically get a message out of the
+                           // mailbox (and wait if there is no message
+                           // to get!); the caller must delete it
     void Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data);
-    // Atomically get a message out of the
-    // mailbox (and wait if there is no message
-    // to get!)
+    // Same, but copy the message out
    private:
     SynchList<Mail *> *messages;  // A mailbox is just a list of arrived messages
 };
@@ -110,12 +118,17 @@ class PostOfficeInput : public CallBackObj {
                  MailHeader *mailHdr, char *data);
     // Retrieve a message from "box".  Wait if
     // there is no message in the box.
+    Mail *Receive(int box);
+    // Same, but hand over the message itself,
+    // without copying it; the caller must
+    // delete it
+    int NumBoxes() { return numBoxes; }
 
     static void PostalDelivery(void *data);
     // Wait for incoming messages,
     // and then put them in the correct mailbox
 
-    void CallBack();  // Called when incoming packet has arrived
+    void CallBack();  // Called when incoming packets have arrived
                       // and can be pulled off of network
                       // (i.e., time to call PostalDelivery)
 
@@ -123,7 +136,8 @@ class PostOfficeInput : public CallBackObj {
     NetworkInput *network;        // Physical network connection
     MailBox *boxes;               // Table of mail boxes to hold incoming mail
     int numBoxes;                 // Number of mail boxes
-    Semaphore *messageAvailable;  // V'ed when message has arrived from network
+    Semaphore *messageAvailable;  // V'ed when messages have arrived from
+                                  // network
 };
 
 class PostOfficeOutput : public CallBackObj {
@@ -139,12 +153,12 @@ class PostOfficeOutput : public CallBackObj {
     // machine.  The fromBox in the MailHeader is
     // the return box for ack's.
 
-    void CallBack();  // Called when outgoing packet has been
-                      // put on network; next packet can now be sent
+    void CallBack();  // Called when outgoing packets have been
+                      // put on network; more packets can now be sent
 
    private:
     NetworkOutput *network;  // Physical network connection
-    Semaphore *messageSent;  // V'ed when next message can be sent to network
-    Lock *sendLock;          // Only one outgoing message at a time
+    Semaphore *slotsFree;    // Room in the network's send ring; V'ed
+                             // once for each packet it is done with
 };
 #endif
@@ -0,0 +1,315 @@
+// transport.cc
+//	Routines to send messages reliably, and in order, over the
+//	unreliable post office: a sliding window of numbered segments,
+//	cumulative acknowledgements, and retransmission when an
+//	acknowledgement is slow to come.
+//
+//	Arriving segments are not copied until Receive reassembles them
+//	into the caller's buffer; until then each stays in the packet
+//	buffer it was read into off the wire (see Mail).
+//
+//	Two threads serve each Connection: the "receiver" waits for mail
+//	in our mailbox, and handles both data and acks from the other
+//	side; the "retransmitter" waits for the retransmission timer,
+//	which is driven by interrupts, and resends the window.  Neither
+//	can be done in the interrupt handlers themselves, because sending
+//	mail requires waiting.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "transport.h"
+
+#include "copyright.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// Connection::Connection
+// 	Set up our end of a connection, and start the threads that
+//	serve it.  No messages are exchanged to do so; the other
+//	machine must set up its end with the mailboxes swapped.
+//
+//	"farHost", "farBox" -- the other end of the connection
+//	"localBox" -- our mailbox for the connection
+//	"window" -- how many segments may be unacknowledged at once
+//----------------------------------------------------------------------
+
+Connection::Connection(NetworkAddress farHost, MailBoxAddress farBox,
+                       MailBoxAddress localBox, int window) {
+    ASSERT(window > 0);
+    this->farHost = farHost;
+    this->farBox = farBox;
+    this->localBox = localBox;
+    this->window = window;
+
+    lock = new Lock("connection");
+    unacked = new TransportSegment[window];
+    sendBase = nextSeq = 0;
+    windowOpen = new Condition("window open");
+    allAcked = new Condition("all acked");
+
+    nextExpected = 0;
+    delivered = new SynchList<Mail *>;
+
+    timerRunning = timerScheduled = FALSE;
+    timerExpires = 0;
+    timedOut = new Semaphore("retransmit", 0);
+
+    Thread *t = new Thread("transport receiver", 1);
+    t->Fork(Connection::Receiver, this);
+    t = new Thread("transport retransmitter", 1);
+    t->Fork(Connection::Retransmitter, this);
+}
+
+//----------------------------------------------------------------------
+// Connection::~Connection
+// 	De-allocate the connection.
+//
+//	As with the post office, the threads serving the connection are
+//	still waiting on it, so we don't deallocate what they wait on.
+//	The retransmitter (and a timer interrupt that is still coming)
+//	may also look at the unacknowledged segments, so we stop the
+//	timer and keep them, too.
+//----------------------------------------------------------------------
+
+Connection::~Connection() {
+    timerRunning = FALSE;
+    delete windowOpen;
+    delete allAcked;
+}
+
+//----------------------------------------------------------------------
+// Connection::Send
+// 	Split a message into segments, and send each one as soon as
+//	there is room for it in the window.  Return once the last
+//	segment has been sent (not necessarily acknowledged).
+//
+//	"data" -- the message
+//	"size" -- how many bytes of it; may be 0
+//----------------------------------------------------------------------
+
+void Connection::Send(char *data, int size) {
+    int sent = 0;
+    TransportSegment *segment;
+
+    lock->Acquire();
+    do {
+        while (nextSeq - sendBase == window) {
+            windowOpen->Wait(lock);
+        }
+        segment = &unacked[nextSeq % window];
+        segment->hdr.seq = nextSeq++;
+        segment->hdr.length = min(size - sent, (int)MaxSegmentSize);
+        segment->hdr.flags = SegData;
+        bcopy(data + sent, segment->data, segment->hdr.length);
+        sent += segment->hdr.length;
+        if (sent == size) {
+            segment->hdr.flags |= SegEnd;
+        }
+        if (!timerRunning) {
+            StartTimer();
+        }
+        Transmit(segment);
+    } while (sent < size);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Connection::Receive
+// 	Wait for the next message from the other side, and reassemble it
+//	from its segments into "data".  If the message is longer than
+//	"size", the rest of it is thrown away.  Return the number of
+//	bytes copied.
+//----------------------------------------------------------------------
+
+int Connection::Receive(char *data, int size) {
+    Mail *mail;
+    SegmentHeader *hdr;
+    int length = 0;
+    bool last;
+
+    do {
+        mail = delivered->RemoveFront();  // wait for the next
+                                          // segment, in order
+        hdr = (SegmentHeader *)mail->data;
+        int n = min((int)hdr->length, size - length);
+
+        bcopy(mail->data + sizeof(SegmentHeader), data + length, n);
+        kernel->stats->numMailBytesCopied += n;
+        length += n;
+        last = (hdr->flags & SegEnd) != 0;
+        delete mail;
+    } while (!last);
+    return length;
+}
+
+//----------------------------------------------------------------------
+// Connection::Flush
+// 	Wait until the other side has acknowledged everything we've sent.
+//----------------------------------------------------------------------
+
+void Connection::Flush() {
+    lock->Acquire();
+    while (sendBase != nextSeq) {
+        allAcked->Wait(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Connection::Transmit
+// 	Send a segment to the other side, acknowledging, while we're at
+//	it, everything we have received from them.
+//----------------------------------------------------------------------
+
+void Connection::Transmit(TransportSegment *segment) {
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    segment->hdr.ack = nextExpected;
+    segment->hdr.flags |= SegAck;
+    pktHdr.to = farHost;
+    mailHdr.to = farBox;
+    mailHdr.from = localBox;
+    mailHdr.length = sizeof(SegmentHeader) + segment->hdr.length;
+    kernel->postOfficeOut->Send(pktHdr, mailHdr, (char *)segment);
+    kernel->stats->numSegmentsSent++;
+}
+
+//----------------------------------------------------------------------
+// Connection::StartTimer
+// 	Give the other side RetransmitTime from now to acknowledge what
+//	we have sent.  There is no way to take back an interrupt once it
+//	is scheduled, so if one is already coming, just move the deadline;
+//	CallBack will wait for the rest of the time.
+//----------------------------------------------------------------------
+
+void Connection::StartTimer() {
+    timerRunning = TRUE;
+    timerExpires = kernel->stats->totalTicks + RetransmitTime;
+    if (!timerScheduled) {
+        timerScheduled = TRUE;
+        kernel->interrupt->Schedule(this, RetransmitTime, NetworkTimeoutInt);
+    }
+}
+
+//----------------------------------------------------------------------
+// Connection::CallBack
+// 	Interrupt handler for the retransmission timer.  If the timer
+//	has been stopped, do nothing; if it has been restarted since the
+//	interrupt was scheduled, wait until the new deadline; otherwise,
+//	wake up the retransmitter.
+//----------------------------------------------------------------------
+
+void Connection::CallBack() {
+    int now = kernel->stats->totalTicks;
+
+    timerScheduled = FALSE;
+    if (!timerRunning) {
+        return;
+    }
+    if (now < timerExpires) {
+        timerScheduled = TRUE;
+        kernel->interrupt->Schedule(this, timerExpires - now, NetworkTimeoutInt);
+        return;
+    }
+    timerRunning = FALSE;
+    timedOut->V();
+}
+
+//----------------------------------------------------------------------
+// Connection::Acknowledged
+// 	The other side has received every segment before "ack".  Slide
+//	the window past them, and restart the timer for the rest, if any.
+//	Acks that are old, or duplicates, change nothing.
+//----------------------------------------------------------------------
+
+void Connection::Acknowledged(int ack) {
+    lock->Acquire();
+    if (ack > sendBase && ack <= nextSeq) {
+        sendBase = ack;
+        windowOpen->Broadcast(lock);
+        if (sendBase == nextSeq) {
+            timerRunning = FALSE;
+            allAcked->Broadcast(lock);
+        } else {
+            StartTimer();
+        }
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Connection::Receiver
+// 	Wait for segments from the other side.  Take note of its acks;
+//	accept its data only in order, and acknowledge what we have
+//	after every data segment, so that a lost or out-of-order segment
+//	produces a duplicate ack rather than silence.
+//----------------------------------------------------------------------
+
+void Connection::Receiver(void *arg) {
+    Connection *_this = (Connection *)arg;
+    Mail *mail;
+    SegmentHeader *hdr;
+    TransportSegment ack;
+
+    for (;;) {
+        mail = kernel->postOfficeIn->Receive(_this->localBox);
+        hdr = (SegmentHeader *)mail->data;
+        if (mail->pktHdr.from != _this->farHost ||
+            mail->mailHdr.from != _this->farBox) {
+            DEBUG(dbgNet, "Segment from a stranger, dropped");
+            delete mail;
+            continue;
+        }
+        if (mail->mailHdr.length < sizeof(SegmentHeader) ||
+            mail->mailHdr.length != sizeof(SegmentHeader) + hdr->length) {
+            DEBUG(dbgNet, "Segment of bad length " << mail->mailHdr.length << ", dropped");
+            delete mail;
+            continue;
+        }
+        if (hdr->flags & SegAck) {
+            _this->Acknowledged(hdr->ack);
+        }
+        if (!(hdr->flags & SegData)) {
+            delete mail;
+            continue;
+        }
+        if (hdr->seq == _this->nextExpected) {
+            _this->delivered->Append(mail);  // the segment stays in
+                                             // the buffer it arrived in
+            _this->nextExpected++;
+        } else {
+            DEBUG(dbgNet, "Segment " << hdr->seq << " out of order, expected " << _this->nextExpected);
+            delete mail;
+        }
+        ack.hdr.flags = 0;
+        ack.hdr.length = 0;
+        _this->Transmit(&ack);
+    }
+}
+
+//----------------------------------------------------------------------
+// Connection::Retransmitter
+// 	Each time the retransmission timer expires, send every segment
+//	that hasn't been acknowledged again, and restart the timer.
+//----------------------------------------------------------------------
+
+void Connection::Retransmitter(void *arg) {
+    Connection *_this = (Connection *)arg;
+
+    for (;;) {
+        _this->timedOut->P();
+        _this->lock->Acquire();
+        DEBUG(dbgNet, "Retransmitting segments " << _this->sendBase << " to " << _this->nextSeq - 1);
+        for (int seq = _this->sendBase; seq < _this->nextSeq; seq++) {
+            _this->Transmit(&_this->unacked[seq % _this->window]);
+            kernel->stats->numSegmentsResent++;
+        }
+        if (_this->sendBase < _this->nextSeq) {
+            _this->StartTimer();
+        }
+        _this->lock->Release();
+    }
+}
@@ -0,0 +1,117 @@
+// transport.h
+//	Data structures for reliable, ordered delivery of messages of
+//	any size between mailboxes on two machines, on top of the post
+//	office.
+//
+//	The post office can lose messages, and each message must fit in
+//	a single packet.  A Connection splits every message into numbered
+//	segments that do fit, and keeps sending them until the other side
+//	acknowledges them.  Up to "window" segments can be waiting for an
+//	acknowledgement at once; an acknowledgement is cumulative (an ack
+//	of n covers every segment before n); and when the retransmission
+//	timer goes off, every segment not yet acknowledged is sent again
+//	("go back N").  The receiver accepts segments only in order, and
+//	gives them back to the caller as the original messages.
+//
+//	Both sides of a connection send their data, and their acks of
+//	the other side's data, to the same mailbox, so a connection uses
+//	one mailbox at each end.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "callback.h"
+#include "copyright.h"
+#include "post.h"
+#include "synch.h"
+#include "synchlist.h"
+
+// The following class defines the transport header.  It is put in
+// front of the data of each segment, inside the mail message.
+
+class SegmentHeader {
+   public:
+    int seq;       // Number of this segment, if it carries data
+    int ack;       // Next segment expected from the other side
+    short flags;   // Which of the SegmentFlags apply
+    short length;  // Bytes of data in this segment
+};
+
+enum SegmentFlag { SegData = 1,  // segment carries message data
+                   SegAck = 2,   // "ack" field is valid
+                   SegEnd = 4 }; // last segment of a message
+
+// Most message data that fits in one segment
+#define MaxSegmentSize (MaxMailSize - sizeof(SegmentHeader))
+
+const int RetransmitTime = 20 * NetworkTime;  // how long to wait for
+                                              // an ack before resending
+
+// A segment, as it goes out on the post office: the header, followed
+// directly by the data.
+
+class TransportSegment {
+   public:
+    SegmentHeader hdr;
+    char data[MaxSegmentSize];
+};
+
+// The following class defines one end of a reliable connection.
+
+class Connection : public CallBackObj {
+   public:
+    Connection(NetworkAddress farHost, MailBoxAddress farBox,
+               MailBoxAddress localBox, int window);
+    // Connect "localBox" on this machine to
+    // "farBox" on "farHost"; allow "window"
+    // segments in flight
+    ~Connection();
+
+    void Send(char *data, int size);
+    // Send a message; return as soon as
+    // the last of it is in the window
+    int Receive(char *data, int size);
+    // Wait for the next message, and copy up
+    // to "size" bytes of it into "data";
+    // return how many bytes were copied
+    void Flush();  // Wait until everything sent so far
+                   // has been acknowledged
+
+    void CallBack();  // The retransmission timer went off
+
+   private:
+    NetworkAddress farHost;   // Where the other end is
+    MailBoxAddress farBox;
+    MailBoxAddress localBox;  // Where our segments arrive
+    int window;               // Most segments not yet acknowledged
+
+    Lock *lock;             // Protects the send window and the timer
+    TransportSegment *unacked;  // Segments sent but not acknowledged;
+                                // segment "seq" is in slot seq % window
+    int sendBase;           // Oldest segment not acknowledged
+    int nextSeq;            // Number of the next segment to send
+    Condition *windowOpen;  // Signalled when acks make room
+    Condition *allAcked;    // Signalled when nothing is unacknowledged
+
+    int nextExpected;  // Next segment we will accept
+    SynchList<Mail *> *delivered;  // Segments accepted, in order,
+                                   // not yet Received
+
+    bool timerRunning;    // Are we waiting for an ack?
+    int timerExpires;     // When to give up waiting for it
+    bool timerScheduled;  // Is a timer interrupt pending?
+    Semaphore *timedOut;  // V'ed when the timer expires
+
+    void Transmit(TransportSegment *segment);
+                                 // Hand a segment to the post office
+    void StartTimer();           // (Re)start the retransmission timer
+    void Acknowledged(int ack);  // The other side has "ack"
+    static void Receiver(void *arg);       // Handle arriving segments
+    static void Retransmitter(void *arg);  // Resend when the timer expires
+};
+
+#endif  // TRANSPORT_H
@@ -0,0 +1,27 @@
+#!/bin/bash
+
+# Run the reliable transport benchmark (-Nt) between two Nachos
+# machines on this host, at several network reliabilities and window
+# sizes, and report the throughput and retransmissions of each run.
+# Usage: ./net_bench.sh [bytes]
+
+BYTES=${1:-20000}
+
+RELIABILITIES=(1 0.95 0.9 0.8)
+WINDOWS=(1 4 16)
+
+NACHOS=../build.linux/nachos
+TIMEOUT="timeout 60s"
+
+echo -e "===== Transport: $BYTES bytes ====="
+for rel in "${RELIABILITIES[@]}"; do
+    for win in "${WINDOWS[@]}"; do
+        FLAGS="-n $rel -window $win -ring $win -Nt $BYTES"
+        $TIMEOUT $NACHOS -m 1 $FLAGS < /dev/null > /dev/null &
+        $TIMEOUT $NACHOS -m 0 $FLAGS < /dev/null | grep "^Transport test:"
+        wait
+    done
+done
+rm -f SOCKET_0 SOCKET_1
+
+exit 0
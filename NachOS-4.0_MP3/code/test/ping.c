@@ -0,0 +1,33 @@
+/* ping.c
+ *	Network test, run on machine 0 while pong runs on machine 1:
+ *
+ *	    nachos -m 1 -e pong &
+ *	    nachos -m 0 -e ping
+ *
+ *	Send numbered messages to mailbox 3 on machine 1, wait for each
+ *	one to come back, and print how many did.
+ */
+
+#include "syscall.h"
+
+#define NumPings 20
+
+int main() {
+	char msg[4];
+	int i, n;
+
+	for (i = 0; i < NumPings; i++) {
+		msg[0] = 'p';
+		msg[1] = 'i';
+		msg[2] = 'n';
+		msg[3] = i;
+		Send(1, 3, msg, 4);
+		n = Receive(3, msg, 4);
+		if (n != 4 || msg[1] != 'o' || msg[3] != i) {
+			break;
+		}
+	}
+	PrintInt(i);
+	Send(1, 3, msg, 0);	/* tell pong to stop */
+	Halt();
+}
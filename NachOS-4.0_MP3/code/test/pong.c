@@ -0,0 +1,18 @@
+/* pong.c
+ *	Network test, run on machine 1 while ping runs on machine 0:
+ *	send every message that arrives in mailbox 3 back to machine 0,
+ *	with "pin" changed to "pon", until an empty one arrives.
+ */
+
+#include "syscall.h"
+
+int main() {
+	char msg[4];
+	int n;
+
+	while ((n = Receive(3, msg, 4)) > 0) {
+		msg[1] = 'o';
+		Send(0, 3, msg, n);
+	}
+	Halt();
+}
@@ -0,0 +1,17 @@
+/* readline.c
+ *	Simple program to test the console line discipline: copy
+ *	console input to the display a line at a time, until the
+ *	input runs out.
+ */
+
+#include "syscall.h"
+
+int main() {
+	char line[80];
+	int n;
+
+	while ((n = ReadLine(line, 80)) > 0) {
+		Write(line, n, SysConsoleOutput);
+	}
+	Halt();
+}
@@ -0,0 +1,22 @@
+#!/bin/bash
+
+# Run the same -ep workload under every scheduling policy, and report
+# the average turnaround, average waiting time and context switches.
+# Usage: ./sched_bench.sh [-ep prog priority ...]
+
+WORKLOAD="$*"
+if [ -z "$WORKLOAD" ]; then
+    WORKLOAD="-ep hw3t1 60 -ep hw3t2 90 -ep hw3t3 50 -ep hw3t1 120"
+fi
+
+POLICIES=(mlfq cfs lottery stride)
+
+TIMEOUT="timeout 10s"
+
+echo -e "===== Workload: $WORKLOAD ====="
+for policy in "${POLICIES[@]}"; do
+    printf "%-8s " "$policy"
+    $TIMEOUT ../build.linux/nachos -sched $policy -ss $WORKLOAD -ee | grep "^Scheduling:"
+done
+
+exit 0
@@ -19,12 +19,18 @@
 //
 //      "doRandom" -- if true, arrange for the hardware interrupts to
 //		occur at random, instead of fixed, intervals.
+//      "doAdapt" -- if true, change the interval between interrupts
+//		with the load (see Alarm::Adapt).
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom) {
+Alarm::Alarm(bool doRandom, bool doAdapt) {
+    adaptive = doAdapt;
     timer = new Timer(doRandom, this);
 }
 
+const int MinTimerTicks = TimerTicks / 4;  // bounds on the adaptive
+const int MaxTimerTicks = TimerTicks * 4;  // time between interrupts
+
 //----------------------------------------------------------------------
 // Alarm::CallBack
 //	Software interrupt handler for the timer device. The timer device is
@@ -46,8 +52,41 @@ Alarm::Alarm(bool doRandom) {
 void Alarm::CallBack() {
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
-    kernel->scheduler->Aging();
-    if (status != IdleMode && kernel->scheduler->ShouldPreempt()) {
+    kernel->stats->numTimerInterrupts++;
+    kernel->scheduler->Tick();
+    kernel->scheduler->AccountCPUs();
+    if (adaptive) {
+	Adapt();
+    }
+    if (status != IdleMode && kernel->scheduler->NumCPUs() > 1) {
+	kernel->scheduler->RequestRotate();	// Yield checks ShouldPreempt
+	interrupt->YieldOnReturn();		// once we are back
+    } else if (status != IdleMode && kernel->scheduler->ShouldPreempt()) {
+	kernel->scheduler->CountPreemption();
 	interrupt->YieldOnReturn();
     }
 }
+
+//----------------------------------------------------------------------
+// Alarm::Adapt
+//	Set the time to the next timer interrupt from the load since the
+//	last one.  If threads woke up (the load is interactive), halve
+//	it, so they get the CPU sooner.  If no CPU has another thread
+//	waiting, double it: there is nobody to switch to, so the
+//	interrupts are wasted.  Otherwise move it back towards TimerTicks.
+//----------------------------------------------------------------------
+
+void Alarm::Adapt() {
+    int interval = timer->GetInterval();
+
+    if (kernel->scheduler->TakeWakeups() > 0) {
+	interval = max(interval / 2, MinTimerTicks);
+    } else if (kernel->scheduler->NumReady() == 0) {
+	interval = min(interval * 2, MaxTimerTicks);
+    } else if (interval < TimerTicks) {
+	interval = min(interval * 2, TimerTicks);
+    } else {
+	interval = max(interval / 2, TimerTicks);
+    }
+    timer->SetInterval(interval);
+}
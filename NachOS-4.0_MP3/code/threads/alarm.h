@@ -25,8 +25,9 @@
 // The following class defines a software alarm clock.
 class Alarm : public CallBackObj {
    public:
-    Alarm(bool doRandomYield);  // Initialize the timer, and callback
-                                // to "toCall" every time slice.
+    Alarm(bool doRandomYield, bool doAdapt = FALSE);
+    // Initialize the timer, and callback
+    // to "toCall" every time slice.
     ~Alarm() { delete timer; }
 
     void WaitUntil(int x);  // suspend execution until time > now + x
@@ -34,6 +35,10 @@ class Alarm : public CallBackObj {
 
    private:
     Timer *timer;  // the hardware timer device
+    bool adaptive;  // stretch the time slice when few threads
+                    // are ready, shrink it when threads wake up often
+
+    void Adapt();   // pick the time to the next timer interrupt
 
     void CallBack();  // called when the hardware
                       // timer generates an interrupt
@@ -9,6 +9,7 @@
 
 #include "copyright.h"
 #include "debug.h"
+#include "frametable.h"
 #include "libtest.h"
 #include "main.h"
 #include "post.h"
@@ -16,6 +17,7 @@
 #include "synch.h"
 #include "synchconsole.h"
 #include "synchdisk.h"
+#include "transport.h"
 #include "synchlist.h"
 #include "sysdep.h"
 
@@ -27,16 +29,29 @@
 
 Kernel::Kernel(int argc, char **argv) {
     randomSlice = FALSE;
+    numCPUs = 1;
+    policy = MLFQ_POLICY;
+    schedStats = FALSE;
+    for (int i = 0; i <= NumLevels; i++) {
+        quanta[i] = 0;
+    }
+    adaptiveSlice = FALSE;
+    traceFile = NULL;  // default is no tracing
     debugUserProg = FALSE;
     execExit = FALSE;
     consoleIn = NULL;   // default is stdin
     consoleOut = NULL;  // default is stdout
+    consoleEcho = FALSE;
+    consoleRaw = FALSE;
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
 #endif
     reliability = 1;  // network reliability, default is 1.0
     hostName = 0;     // machine id, also UNIX socket name
                       // 0 is the default machine id
+    networkRing = 1;  // one packet at a time
+    transportWindow = 8;
+    useNetwork = FALSE;
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-rs") == 0) {
             ASSERT(i + 1 < argc);
@@ -44,6 +59,32 @@ Kernel::Kernel(int argc, char **argv) {
                                             // number generator
             randomSlice = TRUE;
             i++;
+        } else if (strcmp(argv[i], "-cpus") == 0) {
+            ASSERT(i + 1 < argc);
+            numCPUs = atoi(argv[i + 1]);
+            ASSERT(numCPUs >= 1 && numCPUs <= MaxCPUs);
+            i++;
+        } else if (strcmp(argv[i], "-sched") == 0) {
+            ASSERT(i + 1 < argc);
+            if (!PolicyNamed(argv[i + 1], &policy)) {
+                cout << "Unknown scheduling policy " << argv[i + 1] << "\n";
+                Abort();
+            }
+            i++;
+        } else if (strcmp(argv[i], "-ss") == 0) {
+            schedStats = TRUE;
+        } else if (strcmp(argv[i], "-quantum") == 0) {
+            ASSERT(i + NumLevels < argc);
+            for (int level = 1; level <= NumLevels; level++) {
+                quanta[level] = atoi(argv[++i]);
+                ASSERT(quanta[level] >= 0);
+            }
+        } else if (strcmp(argv[i], "-aq") == 0) {
+            adaptiveSlice = TRUE;
+        } else if (strcmp(argv[i], "-tr") == 0) {
+            ASSERT(i + 1 < argc);
+            traceFile = argv[i + 1];
+            i++;
         } else if (strcmp(argv[i], "-s") == 0) {
             debugUserProg = TRUE;
         } else if (strcmp(argv[i], "-e") == 0) {
@@ -68,6 +109,10 @@ Kernel::Kernel(int argc, char **argv) {
             ASSERT(i + 1 < argc);
             consoleOut = argv[i + 1];
             i++;
+        } else if (strcmp(argv[i], "-echo") == 0) {
+            consoleEcho = TRUE;
+        } else if (strcmp(argv[i], "-raw") == 0) {
+            consoleRaw = TRUE;
 #ifndef FILESYS_STUB
         } else if (strcmp(argv[i], "-f") == 0) {
             formatFlag = TRUE;
@@ -79,15 +124,33 @@ Kernel::Kernel(int argc, char **argv) {
         } else if (strcmp(argv[i], "-m") == 0) {
             ASSERT(i + 1 < argc);  // next argument is int
             hostName = atoi(argv[i + 1]);
+            useNetwork = TRUE;
+            i++;
+        } else if (strcmp(argv[i], "-ring") == 0) {
+            ASSERT(i + 1 < argc);  // next argument is int
+            networkRing = atoi(argv[i + 1]);
+            ASSERT(networkRing > 0);
+            i++;
+        } else if (strcmp(argv[i], "-window") == 0) {
+            ASSERT(i + 1 < argc);  // next argument is int
+            transportWindow = atoi(argv[i + 1]);
+            ASSERT(transportWindow > 0);
             i++;
+        } else if (strcmp(argv[i], "-N") == 0 || strcmp(argv[i], "-Nt") == 0) {
+            useNetwork = TRUE;  // the test itself is run by main
         } else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
+            cout << "Partial usage: nachos [-cpus numCPUs]\n";
+            cout << "Partial usage: nachos [-sched mlfq|cfs|lottery|stride] [-ss]\n";
+            cout << "Partial usage: nachos [-quantum L1 L2 L3] [-aq]\n";
+            cout << "Partial usage: nachos [-tr traceFile]\n";
             cout << "Partial usage: nachos [-s]\n";
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
+            cout << "Partial usage: nachos [-echo] [-raw]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-nf]\n";
 #endif
-            cout << "Partial usage: nachos [-n #] [-m #]\n";
+            cout << "Partial usage: nachos [-n #] [-m #] [-ring #] [-window #]\n";
         }
     }
 }
@@ -108,11 +171,17 @@ void Kernel::Initialize() {
     currentThread->setStatus(RUNNING);
 
     stats = new Statistics();        // collect statistics
+    stats->numCPUs = numCPUs;
     interrupt = new Interrupt;       // start up interrupt handling
-    scheduler = new Scheduler();     // initialize the ready queue
-    alarm = new Alarm(randomSlice);  // start up time slicing
+    tracer = new Tracer(traceFile);  // trace scheduler events
+    scheduler = new Scheduler(numCPUs, policy);  // initialize the ready queues
+    scheduler->SetQuanta(quanta);
+    alarm = new Alarm(randomSlice, adaptiveSlice);  // start up time slicing
     machine = new Machine(debugUserProg);
+    frameTable = new FrameTable();
     synchConsoleIn = new SynchConsoleInput(consoleIn);     // input from stdin
+    synchConsoleIn->SetEcho(consoleEcho);
+    synchConsoleIn->SetCanonical(!consoleRaw);
     synchConsoleOut = new SynchConsoleOutput(consoleOut);  // output to stdout
     synchDisk = new SynchDisk();                           //
 #ifdef FILESYS_STUB
@@ -120,8 +189,14 @@ void Kernel::Initialize() {
 #else
     fileSystem = new FileSystem(formatFlag);
 #endif  // FILESYS_STUB
-    // postOfficeIn = new PostOfficeInput(10);
-    // postOfficeOut = new PostOfficeOutput(reliability);
+    if (useNetwork) {  // only if asked for: the post office opens
+                       // a socket, and has a thread of its own
+        postOfficeIn = new PostOfficeInput(10);
+        postOfficeOut = new PostOfficeOutput(reliability);
+    } else {
+        postOfficeIn = NULL;
+        postOfficeOut = NULL;
+    }
 
     interrupt->Enable();
 }
@@ -132,24 +207,30 @@ void Kernel::Initialize() {
 //----------------------------------------------------------------------
 
 Kernel::~Kernel() {
+    if (schedStats) {
+        stats->PrintScheduling();
+    }
+    delete tracer;  // writes out the trace
     delete stats;
     delete interrupt;
     delete scheduler;
     delete alarm;
     delete machine;
+    delete frameTable;
     delete synchConsoleIn;
     delete synchConsoleOut;
     delete synchDisk;
     delete fileSystem;
-    // delete postOfficeIn;
-    // delete postOfficeOut;
+    delete postOfficeIn;
+    delete postOfficeOut;
 
     Exit(0);
 }
 
 //----------------------------------------------------------------------
 // Kernel::ThreadSelfTest
-//      Test threads, semaphores, synchlists
+//      Test threads, semaphores, reader-writer locks, synchlists,
+//	the interrupt queue, the ready queue, and priority inheritance
 //----------------------------------------------------------------------
 
 void Kernel::ThreadSelfTest() {
@@ -158,18 +239,46 @@ void Kernel::ThreadSelfTest() {
 
     LibSelfTest();  // test library routines
 
+    interrupt->SelfTest(1000);  // test the pending interrupt queue
+
     currentThread->SelfTest();  // test thread switching
 
+    Thread::ForkJoinTest(100);  // test thread creation and exit
+
     // test semaphore operation
     semaphore = new Semaphore("test", 0);
     semaphore->SelfTest();
     delete semaphore;
 
+    ReaderWriterLock::SelfTest();  // test both kinds of
+                                   // reader-writer lock
+
     // test locks, condition variables
     // using synchronized lists
     synchList = new SynchList<int>;
     synchList->SelfTest(9);
     delete synchList;
+
+    scheduler->SelfTest(150);  // test the ready queue, a thread
+                               // at each priority
+
+    if (policy == MLFQ_POLICY && numCPUs == 1) {
+        scheduler->InversionTest();  // priority inheritance
+    }
+}
+
+//----------------------------------------------------------------------
+// Kernel::Benchmark
+//      Run the interrupt queue, thread creation and ready queue tests
+//	with enough interrupts and threads to time them.  The last one
+//	has 10000 threads, and their stacks, around at once, so this is
+//	kept out of ThreadSelfTest.
+//----------------------------------------------------------------------
+
+void Kernel::Benchmark() {
+    interrupt->SelfTest(100000);  // time the pending interrupt queue
+    Thread::ForkJoinTest(10000);  // time thread creation and exit
+    scheduler->SelfTest(10000);   // time the ready queue
 }
 
 //----------------------------------------------------------------------
@@ -251,6 +360,154 @@ void Kernel::NetworkTest() {
     // Then we're done!
 }
 
+//----------------------------------------------------------------------
+// Kernel::TransportTest
+//      Measure the throughput of a reliable connection between
+//	machines #0 and #1: machine #0 sends "numBytes" bytes, in
+//	messages of TransportTestSize bytes, and machine #1 answers
+//	with a one-byte message once it has them all.  Machine #0
+//	reports how long that took; both then halt.
+//
+//	Machine #1 waits for its answer to be acknowledged before it
+//	halts, so machine #0 stays up for TransportLinger ticks after
+//	the answer arrives, to acknowledge it again should the first
+//	ack be lost.
+//
+//	Try it with different windows ("-window"), ring sizes ("-ring")
+//	and network reliabilities ("-n"); see test/net_bench.sh.
+//----------------------------------------------------------------------
+
+static const int TransportTestSize = 1000;  // bytes in each message
+static const int TransportLinger = 10 * RetransmitTime;  // how long
+                                        // machine #0 keeps acking
+
+// The following class wakes up the main thread of machine #0 once
+// it has lingered long enough.
+
+class LingerTimer : public CallBackObj {
+   public:
+    LingerTimer() { done = new Semaphore("linger", 0); }
+    ~LingerTimer() { delete done; }
+
+    void Wait() { done->P(); }  // until the interrupt
+    void CallBack() { done->V(); }
+
+   private:
+    Semaphore *done;
+};
+
+void Kernel::TransportTest(int numBytes) {
+    char *buffer = new char[TransportTestSize];
+    int received = 0, start, elapsed;
+    Connection *conn;
+    LingerTimer linger;
+
+    if (hostName != 0 && hostName != 1) {
+        return;
+    }
+    // one connection between mailbox #2 on each machine
+    conn = new Connection(1 - hostName, 2, 2, transportWindow);
+    if (hostName == 1) {
+        while (received < numBytes) {
+            received += conn->Receive(buffer, TransportTestSize);
+        }
+        conn->Send(buffer, 1);
+        cout << "Transport test: received " << received << " bytes\n";
+        conn->Flush();
+        delete[] buffer;
+        interrupt->Halt();
+    }
+
+    for (int i = 0; i < TransportTestSize; i++) {
+        buffer[i] = (char)i;
+    }
+    start = stats->totalTicks;
+    for (int sent = 0; sent < numBytes; sent += TransportTestSize) {
+        conn->Send(buffer, min(TransportTestSize, numBytes - sent));
+    }
+    conn->Receive(buffer, TransportTestSize);  // wait for the answer
+    elapsed = stats->totalTicks - start;
+
+    cout << "Transport test: " << numBytes << " bytes in " << elapsed;
+    cout << " ticks, " << (elapsed > 0 ? (int)(1000.0 * numBytes / elapsed) : 0);
+    cout << " bytes per 1000 ticks, window " << transportWindow;
+    cout << ", ring " << networkRing << ", reliability " << reliability;
+    cout << ", segments sent " << stats->numSegmentsSent;
+    cout << ", retransmitted " << stats->numSegmentsResent << "\n";
+    delete[] buffer;
+
+    // the connection's receiver thread acks any resent answer meanwhile
+    interrupt->Schedule(&linger, TransportLinger, NetworkTimeoutInt);
+    linger.Wait();
+    interrupt->Halt();
+}
+
+//----------------------------------------------------------------------
+// Kernel::FileReadTest
+//      Measure how well threads share the file system: fork
+//	"numThreads" threads, each of which opens the file "name"
+//	FileReadRounds times and reads it to the end, FileReadSize bytes
+//	at a time.  Report how long it took for all of them to finish.
+//
+//	With the real file system, the readers share the directory and
+//	the file header (see ReaderWriterLock), and wait for each other
+//	only at the disk.
+//----------------------------------------------------------------------
+
+static const int FileReadRounds = 10;  // times each thread reads the file
+static const int FileReadSize = 100;   // bytes in each Read
+
+static char *fileReadName;       // file being read
+static int fileReadBytes;        // bytes read by all the threads
+static Semaphore *fileReadDone;  // V'ed by each thread as it finishes
+
+static void
+FileReadThread(void *arg) {
+    char *buffer = new char[FileReadSize];
+    OpenFile *openFile;
+    int n;
+
+    for (int i = 0; i < FileReadRounds; i++) {
+        openFile = kernel->fileSystem->Open(fileReadName);
+        ASSERT(openFile != NULL);
+        while ((n = openFile->Read(buffer, FileReadSize)) > 0) {
+            fileReadBytes += n;
+        }
+        delete openFile;
+    }
+    delete[] buffer;
+    fileReadDone->V();
+}
+
+void Kernel::FileReadTest(char *name, int numThreads) {
+    int start = stats->totalTicks;
+    double hostStart = HostTime();
+    class OpenFile *openFile;  // Kernel::OpenFile hides the class
+
+    openFile = fileSystem->Open(name);
+    if (openFile == NULL) {
+        cout << "File read test: unable to open file " << name << "\n";
+        return;
+    }
+    delete openFile;
+
+    fileReadName = name;
+    fileReadBytes = 0;
+    fileReadDone = new Semaphore("file read done", 0);
+    for (int i = 0; i < numThreads; i++) {
+        Thread *t = new Thread("file reader", i + 1);
+        t->Fork(FileReadThread, NULL);
+    }
+    for (int i = 0; i < numThreads; i++) {
+        fileReadDone->P();
+    }
+    delete fileReadDone;
+
+    cout << "File read test: " << numThreads << " threads read ";
+    cout << fileReadBytes << " bytes in " << stats->totalTicks - start;
+    cout << " ticks, " << HostTime() - hostStart << " seconds\n";
+}
+
 void ForkExecute(Thread *t) {
     if (!t->space->Load(t->getName())) {
         return;  // executable not found
@@ -19,6 +19,7 @@
 #include "thread.h"
 #include "utility.h"
 
+class FrameTable;
 class PostOfficeInput;
 class PostOfficeOutput;
 class SynchConsoleInput;
@@ -39,9 +40,15 @@ class Kernel {
     void ExecAll();
     int Exec(char *name, char* priority);
     void ThreadSelfTest();  // self test of threads and synchronization
+    void Benchmark();       // time the interrupt and ready queues,
+                            // and thread creation
 
     void ConsoleTest();  // interactive console self test
     void NetworkTest();  // interactive 2-machine network test
+    void TransportTest(int numBytes);  // 2-machine reliable
+                                       // transport benchmark
+    void FileReadTest(char *name, int numThreads);
+                                // concurrent file read benchmark
     Thread *getThread(int threadID) { return t[threadID]; }
 
     void PrintInt(int number);
@@ -60,6 +67,7 @@ class Kernel {
     Interrupt *interrupt;   // interrupt status
     Statistics *stats;      // performance metrics
     Alarm *alarm;           // the software alarm clock
+    Tracer *tracer;         // scheduler event trace
     Machine *machine;       // the simulated CPU
     SynchConsoleInput *synchConsoleIn;
     SynchConsoleOutput *synchConsoleOut;
@@ -69,8 +77,11 @@ class Kernel {
     PostOfficeOutput *postOfficeOut;
     bool execExit;       // exit if all threads are finished
     int execRunningNum;  // number of running threads
-    bool usedFrames[NumPhysPages];
+    FrameTable *frameTable;  // physical memory and swap
     int hostName;  // machine identifier
+    int networkRing;  // packets the network device holds
+                      // in each direction
+    int transportWindow;  // segments a Connection keeps in flight
 
    private:
     Thread *t[10];
@@ -79,10 +90,20 @@ class Kernel {
     int execfileNum;
     int threadNum;
     bool randomSlice;    // enable pseudo-random time slicing
+    int numCPUs;         // number of CPUs to simulate
+    PolicyType policy;   // how to schedule the ready threads
+    bool schedStats;     // print scheduling statistics at halt
+    int quanta[NumLevels + 1];  // time slice of each MLFQ level,
+                                // 0 for the default
+    bool adaptiveSlice;  // change the time slice with the load
+    char *traceFile;     // file to write the scheduler trace to
     bool debugUserProg;  // single step user program
     double reliability;  // likelihood messages are dropped
+    bool useNetwork;     // start up the post office
     char *consoleIn;     // file to read console input from
     char *consoleOut;    // file to send console output to
+    bool consoleEcho;    // echo console input
+    bool consoleRaw;     // don't collect console input into lines
 #ifndef FILESYS_STUB
     bool formatFlag;  // format the disk if this is true
 #endif
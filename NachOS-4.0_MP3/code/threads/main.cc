@@ -2,25 +2,54 @@
 //	Driver code to initialize, selftest, and run the
 //	operating system kernel.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
+// Usage: nachos -d <debugflags> -rs <random seed #> -cpus <# of CPUs>
+//              -sched <policy> -ss -quantum <L1> <L2> <L3> -aq
+//              -tr <trace file>
 //              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
+//              -echo -raw
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
-//              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -n <network reliability> -m <machine id> -ring <# of packets>
+//              -z -K -bench -C -N -Nt <# of bytes> -window <# of segments>
+//              -fr <file> <# of threads>
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -cpus simulates several CPUs, each with its own ready queue
+//    -sched picks the scheduling policy: mlfq (the default), cfs,
+//	lottery or stride
+//    -ss prints scheduling statistics (turnaround, waiting time,
+//	context switches, preemptions) when Nachos halts
+//    -quantum sets the time slice, in ticks, of each MLFQ level
+//	(0 keeps the default)
+//    -aq lengthens the time slice when few threads are ready, and
+//	shortens it when threads wake up often
+//    -tr records scheduler events, and writes them to a file when
+//	Nachos halts (see ../../tracestat)
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
 //    -ci specify file for console input (stdin is the default)
 //    -co specify file for console output (stdout is the default)
+//    -echo writes console input back to the display as it is read
+//    -raw hands console input to ReadLine a character at a time,
+//	instead of a line at a time
 //    -n sets the network reliability
-//    -m sets this machine's host id (needed for the network)
+//    -m sets this machine's host id, and starts up the network
+//    -ring sets how many packets the network device can have in
+//	flight in each direction (1 is the default)
 //    -K run a simple self test of kernel threads and synchronization
+//    -bench times the pending interrupt queue, thread creation, and
+//	the ready queue with many interrupts and threads (see
+//	Kernel::Benchmark)
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -Nt measure the throughput of a reliable connection between two
+//	machines (see Kernel::TransportTest)
+//    -window sets how many segments the reliable connection may
+//	have unacknowledged
+//    -fr measures how fast many threads can read the same file at
+//	once (see Kernel::FileReadTest)
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
@@ -160,8 +189,12 @@ int main(int argc, char **argv) {
     char *debugArg = "";
     char *userProgName = NULL;  // default is not to execute a user prog
     bool threadTestFlag = false;
+    bool benchmarkFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
+    int transportTestBytes = 0;  // how much to send in the transport test
+    char *fileReadName = NULL;   // file to read in the file read test
+    int fileReadThreads = 0;     // threads to read it with
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;    // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL;  // name of copied file in Nachos
@@ -187,10 +220,21 @@ int main(int argc, char **argv) {
             i++;
         } else if (strcmp(argv[i], "-K") == 0) {
             threadTestFlag = TRUE;
+        } else if (strcmp(argv[i], "-bench") == 0) {
+            benchmarkFlag = TRUE;
         } else if (strcmp(argv[i], "-C") == 0) {
             consoleTestFlag = TRUE;
         } else if (strcmp(argv[i], "-N") == 0) {
             networkTestFlag = TRUE;
+        } else if (strcmp(argv[i], "-Nt") == 0) {
+            ASSERT(i + 1 < argc);
+            transportTestBytes = atoi(argv[i + 1]);
+            i++;
+        } else if (strcmp(argv[i], "-fr") == 0) {
+            ASSERT(i + 2 < argc);
+            fileReadName = argv[i + 1];
+            fileReadThreads = atoi(argv[i + 2]);
+            i += 2;
         }
 #ifndef FILESYS_STUB
         else if (strcmp(argv[i], "-cp") == 0) {
@@ -215,7 +259,8 @@ int main(int argc, char **argv) {
         else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
-            cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+            cout << "Partial usage: nachos [-K] [-bench] [-C] [-N]\n";
+            cout << "Partial usage: nachos [-fr fileName numThreads]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
@@ -238,12 +283,19 @@ int main(int argc, char **argv) {
     if (threadTestFlag) {
         kernel->ThreadSelfTest();  // test threads and synchronization
     }
+    if (benchmarkFlag) {
+        kernel->Benchmark();  // time the interrupt and ready queues
+    }
     if (consoleTestFlag) {
         kernel->ConsoleTest();  // interactive test of the synchronized console
     }
     if (networkTestFlag) {
         kernel->NetworkTest();  // two-machine test of the network
     }
+    if (transportTestBytes > 0) {
+        kernel->TransportTest(transportTestBytes);  // two-machine reliable
+                                                    // transport benchmark
+    }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL) {
@@ -262,6 +314,10 @@ int main(int argc, char **argv) {
         Print(printFileName);
     }
 #endif  // FILESYS_STUB
+    if (fileReadThreads > 0) {
+        kernel->FileReadTest(fileReadName, fileReadThreads);  // many threads
+                                                              // read one file
+    }
 
     // finally, run an initial user program if requested to do so
 
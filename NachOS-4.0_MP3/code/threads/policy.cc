@@ -0,0 +1,299 @@
+// policy.cc
+//	Routines for the scheduling policies other than the multi-level
+//	feedback queue (which is in scheduler.cc): CFS, lottery and
+//	stride scheduling.
+//
+//	CFS and stride scheduling both charge each thread for the CPU
+//	time it has used, in "virtual" time that runs slower the more
+//	the thread is entitled to; they differ only in how the
+//	entitlement is computed and in the data structure that finds
+//	the thread that is furthest behind.
+//
+// 	These routines assume that interrupts are already disabled.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "policy.h"
+
+#include "copyright.h"
+#include "debug.h"
+#include "main.h"
+
+const int NiceWeight = 100;           // CFS weight at which virtual time
+                                      // runs as fast as real time
+const int SchedLatency = 6 * TimerTicks;  // how far behind the others a
+                                          // waking CFS thread may start
+const int StrideOne = 150;            // stride of a thread with one ticket,
+                                      // per tick
+
+//----------------------------------------------------------------------
+// NewPolicy
+// 	Create an empty ready queue managed by policy "type".
+//----------------------------------------------------------------------
+
+SchedulingPolicy *
+NewPolicy(PolicyType type) {
+    switch (type) {
+        case MLFQ_POLICY:
+            return new MultiLevelFeedBackQueue();
+        case CFS_POLICY:
+            return new CFSPolicy();
+        case LOTTERY_POLICY:
+            return new LotteryPolicy();
+        case STRIDE_POLICY:
+            return new StridePolicy();
+    }
+    ASSERTNOTREACHED();
+    return NULL;
+}
+
+static char *policyNames[] = {"mlfq", "cfs", "lottery", "stride"};
+
+//----------------------------------------------------------------------
+// PolicyNamed
+// 	Look up a policy by the name given to "-sched".  Return FALSE
+//	if there is no such policy.
+//----------------------------------------------------------------------
+
+bool PolicyNamed(char *name, PolicyType *type) {
+    for (int i = 0; i < (int)(sizeof(policyNames) / sizeof(char *)); i++) {
+        if (strcmp(name, policyNames[i]) == 0) {
+            *type = (PolicyType)i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+char *
+PolicyName(PolicyType type) {
+    return policyNames[type];
+}
+
+//----------------------------------------------------------------------
+// Tickets
+// 	Return how many tickets (lottery, stride) or how much weight
+//	(CFS) a thread gets: one more than its priority, so that every
+//	thread gets some.
+//----------------------------------------------------------------------
+
+static int
+Tickets(Thread *thread) {
+    return thread->getPriority() + 1;
+}
+
+//----------------------------------------------------------------------
+// VirtualTime
+// 	Return the virtual time of "thread", including the CPU time it
+//	has used since it was last charged, scaled by "scale" over its
+//	tickets.  If "charge" is set, record the charge.
+//----------------------------------------------------------------------
+
+static int
+VirtualTime(Thread *thread, int scale, bool charge) {
+    int used = thread->runTicks - thread->chargedTicks;
+    int vruntime;
+
+    if (thread == kernel->currentThread) {  // still running; add the
+                                            // time since it was dispatched
+        used += kernel->stats->totalTicks - thread->dispatchTick;
+    }
+    vruntime = thread->vruntime + used * scale / Tickets(thread);
+    if (charge) {
+        thread->vruntime = vruntime;
+        thread->chargedTicks += used;
+    }
+    return vruntime;
+}
+
+//----------------------------------------------------------------------
+// CompareVirtualTime
+// 	Order ready threads by virtual time, then by when they were
+//	queued, so that no two threads compare equal.
+//----------------------------------------------------------------------
+
+static int
+CompareVirtualTime(Thread *t1, Thread *t2) {
+    if (t1->vruntime != t2->vruntime) {
+        return (t1->vruntime < t2->vruntime) ? -1 : 1;
+    }
+    return (t1->readySeq < t2->readySeq) ? -1 : (t1->readySeq > t2->readySeq);
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::CFSPolicy, ~CFSPolicy
+//----------------------------------------------------------------------
+
+CFSPolicy::CFSPolicy() {
+    tree = new RBTree<Thread *>(CompareVirtualTime);
+    minVruntime = 0;
+    numAppended = 0;
+}
+
+CFSPolicy::~CFSPolicy() {
+    delete tree;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Append
+// 	Charge a thread for the CPU time it has used, and put it in the
+//	tree.  A thread that was not running (it is new, or has been
+//	blocked) is not allowed to fall more than SchedLatency behind
+//	the others, or it would hog the CPU to catch up.
+//----------------------------------------------------------------------
+
+void CFSPolicy::Append(Thread *thread) {
+    bool wasRunning = (thread == kernel->currentThread);
+
+    VirtualTime(thread, NiceWeight, TRUE);
+    if (!wasRunning && thread->vruntime < minVruntime - SchedLatency) {
+        thread->vruntime = minVruntime - SchedLatency;
+    }
+    thread->readySeq = numAppended++;
+    tree->Insert(thread);
+    DEBUG(dbgScheduler, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is inserted into the CFS tree, vruntime [" << thread->vruntime << "]");
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::RemoveFront
+// 	Take the thread with the least virtual time out of the tree.
+//----------------------------------------------------------------------
+
+Thread *
+CFSPolicy::RemoveFront() {
+    Thread *thread = tree->RemoveFront();
+
+    if (thread->vruntime > minVruntime) {
+        minVruntime = thread->vruntime;
+    }
+    DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is removed from the CFS tree");
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::ShouldPreempt
+// 	Preempt the running thread once it is a full timer interval of
+//	virtual time ahead of the thread that is furthest behind.
+//----------------------------------------------------------------------
+
+bool CFSPolicy::ShouldPreempt() {
+    if (tree->IsEmpty()) {
+        return FALSE;
+    }
+    return VirtualTime(kernel->currentThread, NiceWeight, FALSE) >=
+           tree->Front()->vruntime + TimerTicks;
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::LotteryPolicy, ~LotteryPolicy
+//----------------------------------------------------------------------
+
+LotteryPolicy::LotteryPolicy() {
+    list = new List<Thread *>;
+    totalTickets = 0;
+}
+
+LotteryPolicy::~LotteryPolicy() {
+    delete list;
+}
+
+void LotteryPolicy::Append(Thread *thread) {
+    list->Append(thread);
+    totalTickets += Tickets(thread);
+    DEBUG(dbgScheduler, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] joins the lottery with [" << Tickets(thread) << "] tickets");
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::RemoveFront
+// 	Draw a winning ticket, and take the thread holding it off the
+//	list.
+//----------------------------------------------------------------------
+
+Thread *
+LotteryPolicy::RemoveFront() {
+    int winner = RandomNumber() % totalTickets;
+    Thread *thread = NULL;
+
+    for (ListIterator<Thread *> it(list); !it.IsDone(); it.Next()) {
+        thread = it.Item();
+        winner -= Tickets(thread);
+        if (winner < 0) {
+            break;
+        }
+    }
+    ASSERT(thread != NULL && winner < 0);
+    list->Remove(thread);
+    totalTickets -= Tickets(thread);
+    DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] wins the lottery");
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::Reposition
+// 	A ready thread's priority has changed, and with it the number
+//	of tickets it holds.  Its place on the list doesn't matter.
+//----------------------------------------------------------------------
+
+void LotteryPolicy::Reposition(Thread *thread, int oldPriority) {
+    totalTickets += Tickets(thread) - (oldPriority + 1);
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::StridePolicy, ~StridePolicy
+//----------------------------------------------------------------------
+
+StridePolicy::StridePolicy() {
+    heap = new Heap<Thread *>(CompareVirtualTime);
+    globalPass = 0;
+    numAppended = 0;
+}
+
+StridePolicy::~StridePolicy() {
+    delete heap;
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::Append
+// 	Advance a thread's pass for the CPU time it has used, and put
+//	it on the heap.  A thread that was not running starts no further
+//	back than the global pass, so it cannot bank time while blocked.
+//----------------------------------------------------------------------
+
+void StridePolicy::Append(Thread *thread) {
+    bool wasRunning = (thread == kernel->currentThread);
+
+    VirtualTime(thread, StrideOne, TRUE);
+    if (!wasRunning && thread->vruntime < globalPass) {
+        thread->vruntime = globalPass;
+    }
+    thread->readySeq = numAppended++;
+    heap->Insert(thread);
+    DEBUG(dbgScheduler, "[A] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is inserted with pass [" << thread->vruntime << "]");
+}
+
+Thread *
+StridePolicy::RemoveFront() {
+    Thread *thread = heap->RemoveFront();
+
+    if (thread->vruntime > globalPass) {
+        globalPass = thread->vruntime;
+    }
+    DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << thread->getID() << "] is removed with pass [" << thread->vruntime << "]");
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::ShouldPreempt
+// 	Preempt the running thread once its pass has moved past that
+//	of some ready thread.
+//----------------------------------------------------------------------
+
+bool StridePolicy::ShouldPreempt() {
+    if (heap->IsEmpty()) {
+        return FALSE;
+    }
+    return VirtualTime(kernel->currentThread, StrideOne, FALSE) >
+           heap->Front()->vruntime;
+}
@@ -0,0 +1,142 @@
+// policy.h
+//	Data structures for scheduling policies.  A policy decides which
+//	of the ready threads runs next, and when the running thread
+//	should be preempted; the Scheduler keeps one ready queue per CPU,
+//	each managed by a policy chosen at boot time (see "-sched").
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "copyright.h"
+#include "heap.h"
+#include "list.h"
+#include "rbtree.h"
+#include "thread.h"
+
+// The scheduling policies that can be selected with "-sched".
+enum PolicyType { MLFQ_POLICY,       // multi-level feedback queue
+                  CFS_POLICY,        // completely fair (virtual run time)
+                  LOTTERY_POLICY,    // random, in proportion to tickets
+                  STRIDE_POLICY };   // deterministic, in proportion
+                                     // to tickets
+
+// The following class defines the interface every policy provides:
+// a queue of ready threads, plus the decisions made on every timer
+// interrupt.  Interrupts are disabled whenever it is called.
+
+class SchedulingPolicy {
+   public:
+    virtual ~SchedulingPolicy() {}
+
+    virtual void Append(Thread *thread) = 0;  // Put a ready thread
+                                              // on the queue
+    virtual Thread *RemoveFront() = 0;  // Take off the thread that
+                                        // should run next
+    virtual bool IsEmpty() = 0;         // no threads are ready?
+    virtual int NumInList() = 0;        // how many threads are ready
+    virtual bool ShouldPreempt() = 0;   // should the running thread
+                                        // give up the CPU now?
+    virtual void Tick() {}              // called on every timer
+                                        // interrupt
+    virtual int Level(Thread *thread) { return 0; }
+                                        // queue level of a thread,
+                                        // 1..NumLevels, if any
+    virtual int Rank(Thread *thread) { return -thread->getPriority(); }
+                                        // order of threads within a
+                                        // level, lowest first; by
+                                        // default, highest priority
+    virtual void SetQuanta(int *quanta) {}
+                                        // time slice for each level
+    virtual void Apply(void (*f)(Thread *)) const = 0;
+                                        // apply function to every
+                                        // ready thread
+    virtual void Reposition(Thread *thread, int oldPriority) {}
+                                        // a ready thread's priority has
+                                        // changed; move it to its new
+                                        // place, if that matters
+};
+
+extern SchedulingPolicy *NewPolicy(PolicyType type);
+                                // Create an empty ready queue
+extern bool PolicyNamed(char *name, PolicyType *type);
+                                // Look up the policy called "name"
+extern char *PolicyName(PolicyType type);
+
+// The following class defines a CFS-style policy: every thread
+// accumulates virtual run time -- CPU time divided by a weight that
+// grows with its priority -- and the ready thread with the least
+// virtual run time runs next.  Ready threads are kept in a red-black
+// tree ordered by virtual run time.
+
+class CFSPolicy : public SchedulingPolicy {
+   public:
+    CFSPolicy();
+    ~CFSPolicy();
+
+    void Append(Thread *thread);
+    Thread *RemoveFront();
+    bool IsEmpty() { return tree->IsEmpty(); }
+    int NumInList() { return tree->NumInList(); }
+    bool ShouldPreempt();
+    void Apply(void (*f)(Thread *)) const { tree->Apply(f); }
+    int Rank(Thread *thread) { return thread->vruntime; }
+
+   private:
+    RBTree<Thread *> *tree;  // ready threads, least virtual time first
+    int minVruntime;         // virtual time of the thread most recently
+                             // picked; never goes backwards
+    int numAppended;         // threads put on the queue so far
+};
+
+// The following class defines a lottery scheduler: each thread holds
+// one ticket more than its priority, and the next thread to run is
+// drawn at random in proportion to its tickets.  A new lottery is
+// held on every timer interrupt.
+
+class LotteryPolicy : public SchedulingPolicy {
+   public:
+    LotteryPolicy();
+    ~LotteryPolicy();
+
+    void Append(Thread *thread);
+    Thread *RemoveFront();
+    bool IsEmpty() { return list->IsEmpty(); }
+    int NumInList() { return list->NumInList(); }
+    bool ShouldPreempt() { return !list->IsEmpty(); }
+    void Apply(void (*f)(Thread *)) const { list->Apply(f); }
+    void Reposition(Thread *thread, int oldPriority);
+
+   private:
+    List<Thread *> *list;  // ready threads
+    int totalTickets;      // tickets held by the ready threads
+};
+
+// The following class defines a stride scheduler, the deterministic
+// counterpart of lottery scheduling: each thread's "pass" advances
+// by its CPU time divided by its tickets, and the ready thread with
+// the lowest pass runs next.
+
+class StridePolicy : public SchedulingPolicy {
+   public:
+    StridePolicy();
+    ~StridePolicy();
+
+    void Append(Thread *thread);
+    Thread *RemoveFront();
+    bool IsEmpty() { return heap->IsEmpty(); }
+    int NumInList() { return heap->NumInList(); }
+    bool ShouldPreempt();
+    void Apply(void (*f)(Thread *)) const { heap->Apply(f); }
+    int Rank(Thread *thread) { return thread->vruntime; }
+
+   private:
+    Heap<Thread *> *heap;  // ready threads, lowest pass first
+    int globalPass;        // pass of the thread most recently picked
+    int numAppended;       // threads put on the queue so far
+};
+
+#endif  // POLICY_H
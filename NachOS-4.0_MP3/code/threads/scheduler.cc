@@ -22,6 +22,10 @@
 #include "copyright.h"
 #include "debug.h"
 #include "main.h"
+#include "synch.h"
+
+const int ZombieBatch = 32;  // finished threads allowed to pile up
+                             // before the next switch deletes them
 
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
@@ -65,27 +69,103 @@ int getLevel(int priority){
 }
 
 
+//----------------------------------------------------------------------
+// CompareAgingDeadline
+//	Order ready threads by when they are next due to age:
+//	maxWaitTime ticks after they last joined the ready queue or aged.
+//	Every thread waits the same time, so this is just "lastTick".
+//----------------------------------------------------------------------
+
+static int CompareAgingDeadline(Thread* t1, Thread* t2){
+    if (t1->lastTick != t2->lastTick){
+	return (t1->lastTick < t2->lastTick) ? -1 : 1;
+    }
+    return (t1->readySeq < t2->readySeq) ? -1 : (t1->readySeq > t2->readySeq);
+}
+
+static void SetAgingIndex(Thread* t, int index){
+    t->agingIndex = index;
+}
+
+//----------------------------------------------------------------------
+// CompareReadyKey
+//	Order the threads in L1 or L2 by the key cached when they were
+//	queued -- remaining burst time in L1, priority negated in L2 --
+//	then by thread ID, just as CompareBurstTime and CompareL2Priority
+//	do, but without recomputing the key on every comparison.
+//----------------------------------------------------------------------
+
+static int CompareReadyKey(Thread* t1, Thread* t2){
+    if (t1->readyKey != t2->readyKey){
+	return (t1->readyKey < t2->readyKey) ? -1 : 1;
+    }
+    if (t1->getID() != t2->getID()){
+	return (t1->getID() < t2->getID()) ? -1 : 1;
+    }
+    return (t1->readySeq < t2->readySeq) ? -1 : (t1->readySeq > t2->readySeq);
+}
+
+static void SetQueueIndex(Thread* t, int index){
+    t->queueIndex = index;
+}
+
+//----------------------------------------------------------------------
+// CompareQueueOrder
+//	Order the threads that age on the same tick the way they sit
+//	in the ready queue -- L1 by burst time, then L2 by priority,
+//	then L3 first come first served -- so the [C] trace comes out
+//	in the same order as when every ready thread was visited.
+//----------------------------------------------------------------------
+
+static int CompareQueueOrder(Thread* t1, Thread* t2){
+    int level1 = getLevel(t1->getPriority());
+    int level2 = getLevel(t2->getPriority());
+
+    if (level1 != level2){
+	return (level1 < level2) ? -1 : 1;
+    }
+    switch (level1){
+	case 1:
+	case 2:
+	    return CompareReadyKey(t1, t2);
+	default:
+	    return (t1->readySeq < t2->readySeq) ? -1 : (t1->readySeq > t2->readySeq);
+    }
+}
+
 MultiLevelFeedBackQueue::MultiLevelFeedBackQueue(){
     l1ApproxBurst = 0;
     maxWaitTime = 1500;
-    L1 = new SortedList<Thread*>(CompareBurstTime);
-    L2 = new SortedList<Thread*>(CompareL2Priority);
+    numAppended = 0;
+    for (int i = 0; i <= NumLevels; i++){
+	timeQuantum[i] = 0;
+    }
+    L1 = new Heap<Thread*>(CompareReadyKey, SetQueueIndex);
+    L2 = new Heap<Thread*>(CompareReadyKey, SetQueueIndex);
     L3 = new List<Thread*>();
+    agingQueue = new Heap<Thread*>(CompareAgingDeadline, SetAgingIndex);
 }
 
 MultiLevelFeedBackQueue::~MultiLevelFeedBackQueue(){
     delete L1;
     delete L2;
     delete L3;
+    delete agingQueue;
 }
 
 void MultiLevelFeedBackQueue::Append(Thread* item){
     int level = getLevel(item->getPriority());
+    if (item->agingIndex < 0){	// newly ready, rather than moving
+	item->readySeq = numAppended++;	// up a level after aging
+	agingQueue->Insert(item);
+    }
     switch (level){
     	case 1:
+	    item->readyKey = item->getBurstTime();
 	    L1->Insert(item);
 	    break;
 	case 2:
+	    item->readyKey = -item->getPriority();
 	    L2->Insert(item);
 	    break;
 	case 3:
@@ -96,10 +176,27 @@ void MultiLevelFeedBackQueue::Append(Thread* item){
 }
 
 
+//----------------------------------------------------------------------
+// MultiLevelFeedBackQueue::SetQuanta
+//	Set the time slice of each level, from quanta[1..NumLevels].
+//	A thread that has used up its level's time slice is preempted
+//	by a ready thread of the same level.  A time slice of 0 keeps
+//	the default: none for L1 and L2, where a thread runs until a
+//	better one is ready, and round robin on every timer interrupt
+//	for L3.
+//----------------------------------------------------------------------
+
+void MultiLevelFeedBackQueue::SetQuanta(int* quanta){
+    for (int i = 1; i <= NumLevels; i++){
+	ASSERT(quanta[i] >= 0);
+	timeQuantum[i] = quanta[i];
+    }
+}
+
 bool MultiLevelFeedBackQueue::ShouldPreempt() {
     Thread* curThread = kernel->currentThread;
     int curLevel = getLevel(curThread->getPriority());
-    if (curLevel == 3 && curThread->accTime >= L3TimeQuantum) {return TRUE;}    
+    int used = curThread->accTime + kernel->stats->totalTicks - curThread->lastTick;
     // curLevel < nextThread
     Thread* next = Front();
     if (!next) return FALSE;
@@ -107,8 +204,14 @@ bool MultiLevelFeedBackQueue::ShouldPreempt() {
 
     // nextLevel < curLevel then should be preempted.
     if (nextLevel < curLevel) return TRUE;
-    if (nextLevel == curLevel && curLevel == 1) {
-        return CompareBurstTime(curThread, next) == 1;
+    if (nextLevel == curLevel) {
+	if (timeQuantum[curLevel] > 0 ? used >= timeQuantum[curLevel]
+				      : curLevel == 3) {
+	    return TRUE;  // time slice is up
+	}
+	if (curLevel == 1) {
+	    return CompareBurstTime(curThread, next) == 1;
+	}
     }
     return FALSE;
 }
@@ -118,6 +221,10 @@ bool MultiLevelFeedBackQueue::IsEmpty(){
     return L1->IsEmpty() && L2->IsEmpty() && L3->IsEmpty();
 }
 
+int MultiLevelFeedBackQueue::NumInList(){
+    return L1->NumInList() + L2->NumInList() + L3->NumInList();
+}
+
 Thread* MultiLevelFeedBackQueue::Front(){
     Thread* selected = NULL;
     if (!L1->IsEmpty()){
@@ -139,42 +246,62 @@ static void agingForQueue(Thread* t){
     int oldPriority = t->getPriority();
     if (waitTime >= 1500){
         t->lastTick = kernel->stats->totalTicks;
-        t->setPriority(oldPriority + 10);
+        t->setPriority(t->getBasePriority() + 10);
+        TRACE(TraceAging, t->getID(), t->getPriority());
         DEBUG(dbgScheduler, "[C] Tick [" << kernel->stats->totalTicks  << "]: Thread ["<< t->getID()  << "] changes its priority from [" << oldPriority << "] to [" << t->getPriority() << "]");
     }
 }
 
+//----------------------------------------------------------------------
+// MultiLevelFeedBackQueue::Aging
+//	Raise the priority of every ready thread that has waited
+//	maxWaitTime ticks, and move it up a queue if its new priority
+//	calls for it.
+//
+//	Only the threads whose aging deadline has passed are looked at;
+//	they are taken off the front of the aging queue, put in ready
+//	queue order, aged, and put back with their next deadline.
+//	Threads promoted out of L3 are moved before those promoted out
+//	of L2, as they were when each queue was walked in turn.  A thread
+//	that stays in L2 is moved to its new place in L2.
+//----------------------------------------------------------------------
+
 void MultiLevelFeedBackQueue::Aging(){
-    Apply(agingForQueue);
-    
-    Thread * to_ch = NULL;
-    for (ListIterator<Thread *> it(L3); ; it.Next()) {
-	if (to_ch) {
-	    L3->Remove(to_ch);
-            Append(to_ch);
-            to_ch = NULL;
-    	}
-    	if (it.IsDone()){
-            break;
-	}
-    	if (getLevel(it.Item()->getPriority()) != 3){
-            to_ch = it.Item();
+    SortedList<Thread*> due(CompareQueueOrder);
+    List<Thread*> fromL3, fromL2;
+    int now = kernel->stats->totalTicks;
+    Thread* t;
+
+    while (!agingQueue->IsEmpty() &&
+	   now - agingQueue->Front()->lastTick >= maxWaitTime){
+	due.Insert(agingQueue->RemoveFront());
+    }
+    while (!due.IsEmpty()){
+	t = due.RemoveFront();
+	int oldLevel = getLevel(t->getPriority());
+	agingForQueue(t);
+	agingQueue->Insert(t);
+	if (getLevel(t->getPriority()) != oldLevel){
+	    if (oldLevel == 3){
+		fromL3.Append(t);
+	    } else {
+		fromL2.Append(t);
+	    }
+	} else if (oldLevel == 2){
+	    t->readyKey = -t->getPriority();
+	    L2->Update(t->queueIndex);
 	}
     }
 
-    for (ListIterator<Thread *> it(L2); ; it.Next()) {
-	if (to_ch){
-	    L2->Remove(to_ch);
-    	    Append(to_ch);
-    	    to_ch = NULL;
-	}
-    
-    	if (it.IsDone()){
-	    break;
-    	}
-    	if (getLevel(it.Item()->getPriority()) != 2){
-            to_ch = it.Item();
-    	}
+    while (!fromL3.IsEmpty()){
+	t = fromL3.RemoveFront();
+	L3->Remove(t);
+	Append(t);
+    }
+    while (!fromL2.IsEmpty()){
+	t = fromL2.RemoveFront();
+	L2->Remove(t->queueIndex);
+	Append(t);
     }
 }
 
@@ -193,6 +320,7 @@ Thread* MultiLevelFeedBackQueue::RemoveFront(){
     }
     DEBUG(dbgScheduler, "[B] Tick [" << kernel->stats->totalTicks << "]: Thread [" << toBeRemoved->getID() << "] is removed from queue L[" << level << "]");
     ASSERT(toBeRemoved);
+    agingQueue->Remove(toBeRemoved->agingIndex);
     return toBeRemoved;
 }
 
@@ -202,6 +330,48 @@ void MultiLevelFeedBackQueue::Apply(void (*f)(Thread*)) const{
     L3->Apply(f);
 }
 
+//----------------------------------------------------------------------
+// MultiLevelFeedBackQueue::Rank
+//	Order threads of the same level the way the level's queue does:
+//	L1 by remaining burst time, L2 by priority, and L3 not at all
+//	(first come, first served).
+//----------------------------------------------------------------------
+
+int MultiLevelFeedBackQueue::Rank(Thread* thread){
+    switch (Level(thread)){
+	case 1:
+	    return thread->getBurstTime();
+	case 2:
+	    return -thread->getPriority();
+	default:
+	    return 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// MultiLevelFeedBackQueue::Reposition
+//	A ready thread's priority has changed from "oldPriority" (it
+//	has inherited a priority through a lock, or lost one).  Take it
+//	out of the queue that priority put it in, and put it in the
+//	queue, and at the place, its new priority calls for.  It keeps
+//	its place in the aging queue.
+//----------------------------------------------------------------------
+
+void MultiLevelFeedBackQueue::Reposition(Thread* thread, int oldPriority){
+    switch (getLevel(oldPriority)){
+	case 1:
+	    L1->Remove(thread->queueIndex);
+	    break;
+	case 2:
+	    L2->Remove(thread->queueIndex);
+	    break;
+	case 3:
+	    L3->Remove(thread);
+	    break;
+    }
+    Append(thread);
+}
+
 int MultiLevelFeedBackQueue::getLevel(int priority){
     if (priority >= 100){
 	return 1;
@@ -216,10 +386,28 @@ int MultiLevelFeedBackQueue::getLevel(int priority){
 
 
 
-Scheduler::Scheduler() {
-    // readyList = new List<Thread *>;
-    readyList = new MultiLevelFeedBackQueue();
-    toBeDestroyed = NULL;
+//----------------------------------------------------------------------
+// Scheduler::Scheduler
+// 	Initialize a ready queue for each of "cpus" CPUs, managed by
+//	"policy".
+//	Initially, no ready threads, and the main thread is running
+//	on CPU 0.
+//----------------------------------------------------------------------
+
+Scheduler::Scheduler(int cpus, PolicyType policy) {
+    ASSERT(cpus >= 1 && cpus <= MaxCPUs);
+    numCPUs = cpus;
+    for (int i = 0; i < numCPUs; i++) {
+        readyList[i] = NewPolicy(policy);
+        running[i] = NULL;
+    }
+    currentCPU = 0;
+    running[0] = kernel->currentThread;  // the main thread
+    running[0]->cpu = 0;
+    rotatePending = FALSE;
+    lastAccounted = 0;
+    numWakeups = 0;
+    zombies = new List<Thread *>;
 }
 
 //----------------------------------------------------------------------
@@ -228,7 +416,10 @@ Scheduler::Scheduler() {
 //----------------------------------------------------------------------
 
 Scheduler::~Scheduler() {
-    delete readyList;
+    for (int i = 0; i < numCPUs; i++) {
+        delete readyList[i];
+    }
+    delete zombies;
 }
 
 //----------------------------------------------------------------------
@@ -236,16 +427,55 @@ Scheduler::~Scheduler() {
 // 	Mark a thread as ready, but not running.
 //	Put it on the ready list, for later scheduling onto the CPU.
 //
+//	A thread goes back to the CPU it last ran on; a thread that
+//	has never run goes to the CPU with the least work.
+//
 //	"thread" is the thread to be put on the ready list.
 //----------------------------------------------------------------------
 
 void Scheduler::ReadyToRun(Thread *thread) {
+    int cpu = thread->cpu;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
     DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
     // cout << "Putting thread on ready list: " << thread->getName() << endl ;
+    if (thread == kernel->currentThread) {  // charge the time it ran
+        thread->runTicks += kernel->stats->totalTicks - thread->dispatchTick;
+        thread->dispatchTick = kernel->stats->totalTicks;
+    }
+    if (cpu < 0) {
+        int load, leastLoad = -1;
+
+        for (int i = 0; i < numCPUs; i++) {
+            load = readyList[i]->NumInList() + (running[i] != NULL);
+            if (leastLoad < 0 || load < leastLoad) {
+                cpu = i;
+                leastLoad = load;
+            }
+        }
+    }
+    if (thread->getStatus() == BLOCKED) {
+        numWakeups++;
+    }
     thread->lastTick = kernel->stats->totalTicks;
+    thread->readySince = kernel->stats->totalTicks;
     thread->setStatus(READY);
-    readyList->Append(thread);
+    thread->cpu = cpu;
+    readyList[cpu]->Append(thread);
+    TRACE(TraceEnqueue, thread->getID(), cpu);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Reprioritize
+// 	The priority of "thread" has changed from "oldPriority".  If it
+//	is on a ready queue, let the queue's policy move it.
+//----------------------------------------------------------------------
+
+void Scheduler::Reprioritize(Thread *thread, int oldPriority) {
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    if (thread->getStatus() == READY && thread->getPriority() != oldPriority) {
+        readyList[thread->cpu]->Reposition(thread, oldPriority);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -258,16 +488,130 @@ void Scheduler::ReadyToRun(Thread *thread) {
 
 Thread *
 Scheduler::FindNextToRun() {
+    Thread *thread;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
-    if (readyList->IsEmpty()) {
-        return NULL;
+    if (readyList[currentCPU]->IsEmpty()) {
+        thread = Steal(currentCPU);
     } else {
-        return readyList->RemoveFront();
+        thread = readyList[currentCPU]->RemoveFront();
+    }
+    if (thread != NULL) {
+        TRACE(TraceDequeue, thread->getID(), currentCPU);
+    }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Steal
+// 	Take a ready thread from whichever other CPU has the most ready
+//	threads, so that "cpu" can run it.  Return NULL if every other
+//	ready queue is empty (as it always is with one CPU).
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::Steal(int cpu) {
+    int victim = -1;
+    Thread *thread;
+
+    for (int i = 0; i < numCPUs; i++) {
+        if (i != cpu && !readyList[i]->IsEmpty() &&
+            (victim < 0 || readyList[i]->NumInList() > readyList[victim]->NumInList())) {
+            victim = i;
+        }
+    }
+    if (victim < 0) {
+        return NULL;
+    }
+    thread = readyList[victim]->RemoveFront();
+    DEBUG(dbgThread, "CPU " << cpu << " steals " << thread->getName() << " from CPU " << victim);
+    kernel->stats->numSteals++;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::FindBusyCPU
+// 	The current CPU has nothing left to run.  Mark it idle, and if
+//	some other CPU has a running thread, give that CPU the Machine
+//	and return its thread, so it can be switched back in.
+//	Return NULL if every CPU is idle.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::FindBusyCPU() {
+    running[currentCPU] = NULL;
+    for (int i = 1; i < numCPUs; i++) {
+        int cpu = (currentCPU + i) % numCPUs;
+
+        if (running[cpu] != NULL) {
+            currentCPU = cpu;
+            return running[cpu];
+        }
     }
+    return NULL;
 }
-void Scheduler::Aging(){
-    this->readyList->Aging();
+
+//----------------------------------------------------------------------
+// Scheduler::Rotate
+// 	Time is up for the current CPU: leave its thread running there,
+//	and switch to the next CPU that has work, either a running
+//	thread, a ready thread, or one it can steal.  Returns once the
+//	Machine comes back around to the current CPU.
+//----------------------------------------------------------------------
+
+void Scheduler::Rotate() {
+    Thread *nextThread = NULL;
+    int cpu = currentCPU;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    rotatePending = FALSE;
+    for (int i = 1; i < numCPUs && nextThread == NULL; i++) {
+        cpu = (currentCPU + i) % numCPUs;
+        if (running[cpu] != NULL) {
+            nextThread = running[cpu];
+        } else if (!readyList[cpu]->IsEmpty()) {
+            nextThread = readyList[cpu]->RemoveFront();
+        } else {
+            nextThread = Steal(cpu);
+        }
+    }
+    if (nextThread != NULL) {
+        currentCPU = cpu;
+        Run(nextThread, FALSE);
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::AccountCPUs
+// 	Charge the ticks since the last call to every CPU that has a
+//	running or ready thread; on real hardware those CPUs would all
+//	have been busy at once.  Called at every timer interrupt.
+//----------------------------------------------------------------------
+
+void Scheduler::AccountCPUs() {
+    Statistics *stats = kernel->stats;
+    int elapsed = stats->totalTicks - lastAccounted;
+
+    for (int i = 0; i < numCPUs; i++) {
+        if (running[i] != NULL || !readyList[i]->IsEmpty()) {
+            stats->cpuBusyTicks[i] += elapsed;
+        }
+    }
+    lastAccounted = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Tick
+// 	Let the policy of each ready queue do its periodic work (for the
+//	multi-level feedback queue, aging).  Called on every timer
+//	interrupt.
+//----------------------------------------------------------------------
+
+void Scheduler::Tick(){
+    for (int i = 0; i < numCPUs; i++) {
+        readyList[i]->Tick();
+    }
 }
 
 //----------------------------------------------------------------------
@@ -293,8 +637,8 @@ void Scheduler::Run(Thread *nextThread, bool finishing) {
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
     if (finishing) {  // mark that we need to delete current thread
-        ASSERT(toBeDestroyed == NULL);
-        toBeDestroyed = oldThread;
+        oldThread->setStatus(ZOMBIE);
+        zombies->Append(oldThread);
     }
 
     if (oldThread->space != NULL) {  // if this thread is a user program,
@@ -307,6 +651,16 @@ void Scheduler::Run(Thread *nextThread, bool finishing) {
     
     DEBUG(dbgScheduler, "[E] Tick [" << kernel->stats->totalTicks << "]: Thread [" << nextThread->getID() << "] is now selected for execution, thread [" << oldThread->getID() << "] is replaced, and it has executed [" << oldThread->accTime  << "] ticks");
 
+    kernel->stats->numContextSwitches++;
+    TRACE(TraceSwitch, nextThread->getID(), oldThread->getID());
+    oldThread->runTicks += kernel->stats->totalTicks - oldThread->dispatchTick;
+    if (nextThread->getStatus() == READY) {  // not just back from
+                                             // another CPU's turn
+        nextThread->waitTicks += kernel->stats->totalTicks - nextThread->readySince;
+    }
+    nextThread->dispatchTick = kernel->stats->totalTicks;
+    running[currentCPU] = nextThread;
+    nextThread->cpu = currentCPU;
     kernel->currentThread = nextThread;  // switch to the next thread
     nextThread->setStatus(RUNNING);      // nextThread is now running
     
@@ -339,17 +693,79 @@ void Scheduler::Run(Thread *nextThread, bool finishing) {
 
 //----------------------------------------------------------------------
 // Scheduler::CheckToBeDestroyed
-// 	If the old thread gave up the processor because it was finishing,
-// 	we need to delete its carcass.  Note we cannot delete the thread
+// 	If threads gave up the processor because they were finishing,
+// 	we need to delete their carcasses.  Note we cannot delete a thread
 // 	before now (for example, in Thread::Finish()), because up to this
 // 	point, we were still running on the old thread's stack!
+//
+//	Deleting threads is put off until ZombieBatch of them have
+//	piled up, or until the CPU has nothing better to do (see
+//	Thread::Sleep), so that a burst of exiting threads does not
+//	slow down every context switch.
 //----------------------------------------------------------------------
 
 void Scheduler::CheckToBeDestroyed() {
-    if (toBeDestroyed != NULL) {
-        delete toBeDestroyed;
-        toBeDestroyed = NULL;
+    if (zombies->NumInList() >= ZombieBatch) {
+        ReclaimZombies();
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ReclaimZombies
+// 	Delete every finished thread.  None of them can be running, so
+//	we cannot be on any of their stacks.
+//----------------------------------------------------------------------
+
+void Scheduler::ReclaimZombies() {
+    while (!zombies->IsEmpty()) {
+        delete zombies->RemoveFront();
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetQuanta
+// 	Give every ready queue the time slice "quanta[level]" for each
+//	level; ignored by policies without levels.
+//----------------------------------------------------------------------
+
+void Scheduler::SetQuanta(int *quanta) {
+    for (int i = 0; i < numCPUs; i++) {
+        readyList[i]->SetQuanta(quanta);
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CountPreemption
+// 	Record that the timer is taking the CPU away from the running
+//	thread, by the level the thread is at.
+//----------------------------------------------------------------------
+
+void Scheduler::CountPreemption() {
+    int level = readyList[currentCPU]->Level(kernel->currentThread);
+
+    kernel->stats->numPreemptions[level]++;
+    TRACE(TracePreempt, kernel->currentThread->getID(), level);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NumReady, Scheduler::TakeWakeups
+// 	Report the load, for the adaptive time slice (see Alarm::Adapt).
+//----------------------------------------------------------------------
+
+int Scheduler::NumReady() {
+    int ready = 0;
+
+    for (int i = 0; i < numCPUs; i++) {
+        ready += readyList[i]->NumInList();
     }
+    return ready;
+}
+
+int Scheduler::TakeWakeups() {
+    int woken = numWakeups;
+
+    numWakeups = 0;
+    return woken;
 }
 
 //----------------------------------------------------------------------
@@ -359,5 +775,173 @@ void Scheduler::CheckToBeDestroyed() {
 //----------------------------------------------------------------------
 void Scheduler::Print() {
     cout << "Ready list contents:\n";
-    readyList->Apply(ThreadPrint);
+    for (int i = 0; i < numCPUs; i++) {
+        if (numCPUs > 1) {
+            cout << "CPU " << i << ":\n";
+        }
+        readyList[i]->Apply(ThreadPrint);
+    }
+}
+
+//----------------------------------------------------------------------
+// StressThread
+// 	Body of each thread forked by Scheduler::SelfTest: give up the
+//	CPU a few times, then finish.
+//
+//	"rounds" is the number of times to yield
+//----------------------------------------------------------------------
+
+static int stressLeft;  // stress threads that have not finished
+
+static void
+StressThread(int rounds) {
+    for (int i = 0; i < rounds; i++) {
+        kernel->currentThread->Yield();
+    }
+    stressLeft--;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SelfTest
+// 	Put "numThreads" threads, spread over all three levels, on the
+//	ready queue at once, and let them yield to each other until
+//	they are all done.  Print how long, in real time, it took to
+//	queue each thread and to do each context switch.
+//----------------------------------------------------------------------
+
+void Scheduler::SelfTest(int numThreads) {
+    const int rounds = 2;
+    double start, forked, finish;
+    int switches;
+    Thread *t;
+
+    DEBUG(dbgThread, "Entering Scheduler::SelfTest");
+
+    stressLeft = numThreads;
+    start = HostTime();
+    for (int i = 0; i < numThreads; i++) {
+        t = new Thread("stress thread", i + 1);
+        t->setPriority(i % 150);
+        t->approxBurstTime = RandomNumber() % 1000;
+        t->Fork((VoidFunctionPtr)StressThread, (void *)rounds);
+    }
+    forked = HostTime();
+
+    switches = kernel->stats->numContextSwitches;
+    while (stressLeft > 0) {
+        kernel->currentThread->Yield();
+    }
+    finish = HostTime();
+    switches = kernel->stats->numContextSwitches - switches;
+
+    cout << "Scheduler self test: " << numThreads << " threads, "
+         << (forked - start) * 1000000.0 / numThreads
+         << " us to fork, " << switches << " context switches, "
+         << (finish - forked) * 1000000.0 / switches
+         << " us per switch\n";
+}
+
+//----------------------------------------------------------------------
+// InversionHolder, InversionHog, InversionWaiter
+// 	Bodies of the threads forked by Scheduler::InversionTest: an L3
+//	thread that holds the lock for a while, L2 threads that just
+//	use the CPU, and an L1 thread that wants the lock.
+//----------------------------------------------------------------------
+
+static const int InversionHold = 50;       // clock ticks the lock is
+                                           // held for
+static const int InversionHogTicks = 500;  // clock ticks each L2
+                                           // thread computes for
+static const int InversionHogs = 3;        // L2 threads
+
+static Lock *inversionLock;
+static bool inversionHeld;        // has the L3 thread got the lock?
+static int inversionLatency;      // how long the L1 thread waited for it
+static Semaphore *inversionDone;  // V'ed by each thread as it finishes
+
+static void
+Compute(int numTicks) {  // keep the CPU, letting the clock run
+    for (int i = 0; i < numTicks; i++) {
+        (void)kernel->interrupt->SetLevel(IntOff);
+        (void)kernel->interrupt->SetLevel(IntOn);  // advances the clock
+    }
+}
+
+static void
+InversionHolder(void *arg) {
+    inversionLock->Acquire();
+    inversionHeld = TRUE;
+    Compute(InversionHold);
+    inversionLock->Release();
+    inversionDone->V();
+}
+
+static void
+InversionHog(void *arg) {
+    Compute(InversionHogTicks);
+    inversionDone->V();
+}
+
+static void
+InversionWaiter(void *arg) {
+    int start = kernel->stats->totalTicks;
+
+    inversionLock->Acquire();
+    inversionLatency = kernel->stats->totalTicks - start;
+    inversionLock->Release();
+    inversionDone->V();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::InversionTest
+// 	Check that an L1 thread waiting for a lock held by an L3 thread
+//	gets it once the L3 thread is done with it, even though L2
+//	threads are ready to use the CPU all that time.  Without
+//	priority inheritance, the L3 thread would get the CPU back only
+//	when the L2 threads finished, or when it had aged into L2.
+//
+//	Meant for the multi-level feedback queue, on one CPU.
+//----------------------------------------------------------------------
+
+void Scheduler::InversionTest() {
+    int bound = InversionHold * SystemTick + 2 * TimerTicks;
+    IntStatus oldLevel;
+    Thread *t;
+
+    DEBUG(dbgThread, "Entering Scheduler::InversionTest");
+
+    inversionLock = new Lock("inversion");
+    inversionDone = new Semaphore("inversion done", 0);
+    inversionHeld = FALSE;
+
+    t = new Thread("inversion holder", 1);
+    t->setPriority(10);  // L3
+    t->Fork(InversionHolder, NULL);
+    while (!inversionHeld) {
+        kernel->currentThread->Yield();
+    }
+    // we run at L3 too; a time slice ending before the waiter is
+    // forked would let the hogs run to completion first, and the
+    // test would pass without the waiter ever blocking on the lock
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    for (int i = 0; i < InversionHogs; i++) {
+        t = new Thread("inversion hog", i + 2);
+        t->setPriority(60);  // L2
+        t->Fork(InversionHog, NULL);
+    }
+    t = new Thread("inversion waiter", InversionHogs + 2);
+    t->setPriority(120);  // L1
+    t->Fork(InversionWaiter, NULL);
+    (void)kernel->interrupt->SetLevel(oldLevel);
+
+    for (int i = 0; i < InversionHogs + 2; i++) {
+        inversionDone->P();
+    }
+    delete inversionDone;
+    delete inversionLock;
+
+    cout << "Priority inversion test: L1 thread waited " << inversionLatency
+         << " ticks for a lock held at L3, with " << InversionHogs
+         << " L2 threads ready (bound " << bound << ")\n";
+    ASSERT(inversionLatency <= bound);
 }
@@ -10,8 +10,12 @@
 #define SCHEDULER_H
 
 #include "copyright.h"
+#include "heap.h"
 #include "list.h"
+#include "policy.h"
+#include "stats.h"
 #include "thread.h"
+#include "trace.h"
 
 // The following class defines the scheduler/dispatcher abstraction --
 // the data structures and operations needed to keep track of which
@@ -20,7 +24,7 @@
 int compareBurstTime(Thread* t1, Thread* t2);
 int CompareL2Priority(Thread* t1, Thread* t2);
 
-class MultiLevelFeedBackQueue{
+class MultiLevelFeedBackQueue : public SchedulingPolicy {
    public:
       MultiLevelFeedBackQueue();
       ~MultiLevelFeedBackQueue();
@@ -29,46 +33,102 @@ class MultiLevelFeedBackQueue{
       Thread* RemoveFront();
       void Append(Thread* item);
       void Aging();
+      void Tick() { Aging(); }
+      int Level(Thread* thread) { return getLevel(thread->getPriority()); }
+      int Rank(Thread* thread);
+      void SetQuanta(int* quanta);
       bool IsEmpty();
+      int NumInList();	// how many threads are ready
       bool ShouldPreempt();
       void Apply(void (*f)(Thread*)) const;
+      void Reposition(Thread* thread, int oldPriority);
 
    protected:
 	int getLevel(int priority);
       	int numInList;
 	int l1ApproxBurst;
-     	int L3TimeQuantum;
+	int timeQuantum[NumLevels + 1];	// time slice at each level;
+					// 0 for the default
 	int maxWaitTime;
+	int numAppended;	// threads put on the ready queue so far
 
-	SortedList<Thread*>* L1;
-     	SortedList<Thread*>* L2;
+	Heap<Thread*>* L1;	// by remaining burst time
+     	Heap<Thread*>* L2;	// by priority
       	List<Thread*>* L3;
+	Heap<Thread*>* agingQueue;	// ready threads, by when they are
+					// next due to age
 };
 
 
+// The ready queues are managed by a SchedulingPolicy, chosen at boot.
+//
+// The scheduler can simulate several CPUs sharing the one Machine.
+// Each CPU has its own ready queue and its own running thread; the
+// CPUs take turns on the Machine, moving to the next CPU at every
+// timer interrupt, so their threads' instructions are interleaved
+// in simulated time.  Each thread keeps its own copy of the user
+// registers, so the CPUs do not need separate register sets.
+// A thread that becomes ready goes back to the CPU it last ran on;
+// a CPU with nothing to do steals a thread from the CPU with the
+// most ready threads.
+
 class Scheduler {
    public:
-    Scheduler();   // Initialize list of ready threads
+    Scheduler(int cpus = 1, PolicyType policy = MLFQ_POLICY);
+    // Initialize list of ready threads
     ~Scheduler();  // De-allocate ready list
 
     void ReadyToRun(Thread* thread);
     // Thread can be dispatched.
+    void Reprioritize(Thread* thread, int oldPriority);
+    // Thread's priority has changed
     Thread* FindNextToRun();  // Dequeue first thread on the ready
                               // list, if any, and return thread.
+    Thread* FindBusyCPU();    // Leave this CPU idle, and return the
+                              // running thread of another CPU, if any
     void Run(Thread* nextThread, bool finishing);
     // Cause nextThread to start running
-    void CheckToBeDestroyed();  // Check if thread that had been
-                                // running needs to be deleted
+    void CheckToBeDestroyed();  // Delete the finished threads, if
+                                // enough of them have piled up
+    void ReclaimZombies();      // Delete all the finished threads
     void Print();               // Print contents of ready list
+    void SetQuanta(int* quanta);  // Set the time slice of each level
     
-    bool ShouldPreempt(){return readyList->ShouldPreempt();}    
-    void Aging();
-    // SelfTest for scheduler is implemented in class Thread
+    bool ShouldPreempt(){return readyList[currentCPU]->ShouldPreempt();}    
+    int Level(Thread* thread) { return readyList[currentCPU]->Level(thread); }
+    int Rank(Thread* thread) { return readyList[currentCPU]->Rank(thread); }
+                                // where the policy would put "thread"
+                                // among the ready threads
+    void Tick();  // Called on every timer interrupt
+    void SelfTest(int numThreads);  // time context switches among
+                                    // "numThreads" ready threads
+    void InversionTest();  // check that a lock held by an L3
+                           // thread can't hold up an L1 thread
+
+    int NumCPUs() { return numCPUs; }
+    int CurrentCPU() { return currentCPU; }
+    void RequestRotate() { rotatePending = TRUE; }
+    bool RotatePending() { return rotatePending; }
+    void Rotate();        // Give the Machine to the next CPU
+    void AccountCPUs();   // Charge the ticks since the last call
+                          // to the CPUs that had work to do
+    void CountPreemption();  // The running thread is being preempted
+    int NumReady();       // threads ready on all the CPUs
+    int TakeWakeups();    // threads woken up since the last call
 
    private:
-    MultiLevelFeedBackQueue* readyList;
-    Thread* toBeDestroyed;     // finishing thread to be destroyed
-                               // by the next thread that runs
+    SchedulingPolicy* readyList[MaxCPUs];  // one per CPU
+    Thread* running[MaxCPUs];  // thread on each CPU, NULL if idle
+    int numCPUs;               // how many CPUs are simulated
+    int currentCPU;            // the CPU that has the Machine
+    bool rotatePending;        // move to the next CPU at the next Yield
+    int lastAccounted;         // when AccountCPUs was last called
+    int numWakeups;            // blocked threads made ready since
+                               // the last TakeWakeups
+    List<Thread*>* zombies;    // finished threads, to be destroyed
+                               // once we are off their stacks
+
+    Thread* Steal(int cpu);    // Take a ready thread from another CPU
 };
 
 #endif  // SCHEDULER_H
@@ -18,15 +18,16 @@
 //
 // Once we'e implemented one set of higher level atomic operations,
 // we can implement others using that implementation.  We illustrate
-// this by implementing locks and condition variables on top of
-// semaphores, instead of directly enabling and disabling interrupts.
+// this by implementing reader-writer locks on top of locks and
+// condition variables.
 //
-// Locks are implemented using a semaphore to keep track of
-// whether the lock is held or not -- a semaphore value of 0 means
-// the lock is busy; a semaphore value of 1 means the lock is free.
-//
-// The implementation of condition variables using semaphores is
-// a bit trickier, as explained below under Condition::Wait.
+// Semaphores, locks and condition variables all keep their waiting
+// threads on a WaitQueue, so that the thread woken up is the one the
+// scheduler would pick.  Locks are implemented directly, with
+// interrupts disabled, rather than with a semaphore, because they
+// need to know who holds them and who is waiting, to pass priorities
+// from the waiters to the holder.  Condition variables are too, as
+// explained below under Condition::Wait.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -37,6 +38,86 @@
 #include "copyright.h"
 #include "main.h"
 
+//----------------------------------------------------------------------
+// CompareWaitRank
+// 	Order waiting threads by the level, then the key, the scheduler
+//	gave them when they started to wait, then by when that was, so
+//	that no two threads compare equal.
+//----------------------------------------------------------------------
+
+static int
+CompareWaitRank(Thread *t1, Thread *t2) {
+    if (t1->waitLevel != t2->waitLevel) {
+        return (t1->waitLevel < t2->waitLevel) ? -1 : 1;
+    }
+    if (t1->waitKey != t2->waitKey) {
+        return (t1->waitKey < t2->waitKey) ? -1 : 1;
+    }
+    return (t1->waitSeq < t2->waitSeq) ? -1 : (t1->waitSeq > t2->waitSeq);
+}
+
+static void
+SetWaitIndex(Thread *thread, int index) {
+    thread->waitIndex = index;
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::WaitQueue, ~WaitQueue
+//----------------------------------------------------------------------
+
+WaitQueue::WaitQueue() {
+    heap = new Heap<Thread *>(CompareWaitRank, SetWaitIndex);
+    numAppended = 0;
+}
+
+WaitQueue::~WaitQueue() {
+    delete heap;
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::Append
+// 	Ask the scheduler where "thread" would go among the ready threads,
+//	and queue it in that order.  The thread must already have ended
+//	its CPU burst (Thread::UpdateBurstEstimate), since the rank may
+//	depend on it.
+//----------------------------------------------------------------------
+
+void WaitQueue::Append(Thread *thread) {
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(thread->waitIndex < 0);  // on one queue at a time
+    thread->waitLevel = kernel->scheduler->Level(thread);
+    thread->waitKey = kernel->scheduler->Rank(thread);
+    thread->waitSeq = numAppended++;
+    heap->Insert(thread);
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::RemoveFront
+// 	Take the best-ranked thread off the queue, and return it.
+//	The queue must not be empty.
+//----------------------------------------------------------------------
+
+Thread *
+WaitQueue::RemoveFront() {
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    return heap->RemoveFront();
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::Reposition
+// 	The priority of a waiting thread has changed.  Rank it again,
+//	and move it to its new place; it keeps its place among threads
+//	that rank the same.
+//----------------------------------------------------------------------
+
+void WaitQueue::Reposition(Thread *thread) {
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(thread->waitIndex >= 0);
+    thread->waitLevel = kernel->scheduler->Level(thread);
+    thread->waitKey = kernel->scheduler->Rank(thread);
+    heap->Update(thread->waitIndex);
+}
+
 //----------------------------------------------------------------------
 // Semaphore::Semaphore
 // 	Initialize a semaphore, so that it can be used for synchronization.
@@ -48,7 +129,7 @@
 Semaphore::Semaphore(char *debugName, int initialValue) {
     name = debugName;
     value = initialValue;
-    queue = new List<Thread *>;
+    queue = new WaitQueue;
 }
 
 //----------------------------------------------------------------------
@@ -80,6 +161,7 @@ void Semaphore::P() {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
     while (value == 0) {               // semaphore not available
+        currentThread->UpdateBurstEstimate();  // before we are ranked
         queue->Append(currentThread);  // so go to sleep
         currentThread->Sleep(FALSE);
     }
@@ -91,7 +173,8 @@ void Semaphore::P() {
 
 //----------------------------------------------------------------------
 // Semaphore::V
-// 	Increment semaphore value, waking up a waiter if necessary.
+// 	Increment semaphore value, waking up a waiter if necessary --
+//	the one the scheduler ranks first.
 //	As with P(), this operation must be atomic, so we need to disable
 //	interrupts.  Scheduler::ReadyToRun() assumes that interrupts
 //	are disabled when it is called.
@@ -151,8 +234,9 @@ void Semaphore::SelfTest() {
 
 Lock::Lock(char *debugName) {
     name = debugName;
-    semaphore = new Semaphore("lock", 1);  // initially, unlocked
-    lockHolder = NULL;
+    lockHolder = NULL;  // initially, unlocked
+    waiters = new WaitQueue;
+    nextHeld = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -160,36 +244,152 @@ Lock::Lock(char *debugName) {
 // 	Deallocate a lock
 //----------------------------------------------------------------------
 Lock::~Lock() {
-    delete semaphore;
+    delete waiters;
 }
 
 //----------------------------------------------------------------------
 // Lock::Acquire
 //	Atomically wait until the lock is free, then set it to busy.
-//	Equivalent to Semaphore::P(), with the semaphore value of 0
-//	equal to busy, and semaphore value of 1 equal to free.
+//
+//	While we wait, the holder (and anyone it waits for) inherits our
+//	priority, if that is higher than its own, so that a thread of
+//	middling priority can't keep it from finishing with the lock.
+//	Release hands the lock to us directly, so once we wake up, we
+//	have it.
 //----------------------------------------------------------------------
 
 void Lock::Acquire() {
-    semaphore->P();
-    lockHolder = kernel->currentThread;
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
+
+    // disable interrupts
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (lockHolder != NULL) {  // lock busy, so go to sleep
+        currentThread->UpdateBurstEstimate();  // before we are ranked
+        waiters->Append(currentThread);
+        currentThread->waitingFor = this;
+        Donate(lockHolder, currentThread->getPriority());
+        currentThread->Sleep(FALSE);
+        ASSERT(lockHolder == currentThread);
+    } else {
+        lockHolder = currentThread;
+        nextHeld = currentThread->locksHeld;
+        currentThread->locksHeld = this;
+    }
+
+    // re-enable interrupts
+    (void)interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
 // Lock::Release
-//	Atomically set lock to be free, waking up a thread waiting
-//	for the lock, if any.
-//	Equivalent to Semaphore::V(), with the semaphore value of 0
-//	equal to busy, and semaphore value of 1 equal to free.
+//	Atomically set lock to be free, or, if threads are waiting for
+//	it, give it to the one the scheduler ranks first, and wake it up.
+//
+//	We give up whatever priority we inherited through this lock.
+//	If that leaves a ready thread more deserving of the CPU than we
+//	are, let it have the CPU now, rather than at the next timer
+//	interrupt.
 //
 //	By convention, only the thread that acquired the lock
 // 	may release it.
 //---------------------------------------------------------------------
 
 void Lock::Release() {
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
+    Thread *next;
+    Lock **link;
+    int oldPriority;
+    bool yield;
+
     ASSERT(IsHeldByCurrentThread());
-    lockHolder = NULL;
-    semaphore->V();
+
+    // disable interrupts
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    for (link = &currentThread->locksHeld; *link != this; link = &(*link)->nextHeld) {
+        ASSERT(*link != NULL);
+    }
+    *link = nextHeld;  // take this lock off our list
+
+    oldPriority = currentThread->getPriority();
+    currentThread->inheritedPriority = -1;
+    for (Lock *held = currentThread->locksHeld; held != NULL; held = held->nextHeld) {
+        currentThread->inheritedPriority =
+            max(currentThread->inheritedPriority, held->TopWaiterPriority());
+    }
+
+    next = waiters->IsEmpty() ? NULL : waiters->RemoveFront();
+    lockHolder = next;
+    if (next != NULL) {  // hand the lock over
+        next->waitingFor = NULL;
+        nextHeld = next->locksHeld;
+        next->locksHeld = this;
+        next->inheritedPriority = max(next->inheritedPriority, TopWaiterPriority());
+        kernel->scheduler->ReadyToRun(next);
+    }
+
+    yield = currentThread->getPriority() < oldPriority && oldLevel == IntOn &&
+            kernel->scheduler->ShouldPreempt();
+
+    // re-enable interrupts
+    (void)interrupt->SetLevel(oldLevel);
+
+    if (yield) {
+        currentThread->Yield();
+    }
+}
+
+//----------------------------------------------------------------------
+// Lock::TopWaiterPriority
+//	Return the highest priority among the threads waiting for the
+//	lock, or -1 if no one is waiting.  The waiters aren't ordered by
+//	priority alone (under MLFQ, L1 is ordered by burst time), so we
+//	look at all of them.
+//
+//	Interrupts are disabled.
+//----------------------------------------------------------------------
+
+static int topPriority;  // highest priority seen by NoteTopPriority
+
+static void
+NoteTopPriority(Thread *thread) {
+    topPriority = max(topPriority, thread->getPriority());
+}
+
+int Lock::TopWaiterPriority() {
+    topPriority = -1;
+    waiters->Apply(NoteTopPriority);
+    return topPriority;
+}
+
+//----------------------------------------------------------------------
+// Lock::Donate
+//	A thread of priority "priority" is waiting for a lock "thread"
+//	holds.  Raise the priority of "thread" to match, if it is lower,
+//	and if "thread" is itself waiting for a lock, move it up among
+//	that lock's waiters, and do the same for the holder of that
+//	lock, and so on.  A thread that is already running at least as
+//	high ends the chain.
+//
+//	Interrupts are disabled.
+//----------------------------------------------------------------------
+
+void Lock::Donate(Thread *thread, int priority) {
+    while (thread != NULL && thread->getPriority() < priority) {
+        int oldPriority = thread->getPriority();
+
+        DEBUG(dbgThread, "Thread " << thread->getName() << " inherits priority " << priority);
+        thread->inheritedPriority = priority;
+        kernel->scheduler->Reprioritize(thread, oldPriority);
+        if (thread->waitingFor == NULL) {
+            break;
+        }
+        thread->waitingFor->waiters->Reposition(thread);
+        thread = thread->waitingFor->lockHolder;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -202,7 +402,7 @@ void Lock::Release() {
 //----------------------------------------------------------------------
 Condition::Condition(char *debugName) {
     name = debugName;
-    waitQueue = new List<Semaphore *>;
+    waitQueue = new WaitQueue;
 }
 
 //----------------------------------------------------------------------
@@ -217,11 +417,10 @@ Condition::~Condition() {
 //----------------------------------------------------------------------
 // Condition::Wait
 // 	Atomically release monitor lock and go to sleep.
-//	Our implementation uses semaphores to implement this, by
-//	allocating a semaphore for each waiting thread.  The signaller
-//	will V() this semaphore, so there is no chance the waiter
-//	will miss the signal, even though the lock is released before
-//	calling P().
+//	We disable interrupts from before we join the wait queue until
+//	we are asleep, so there is no chance we will miss the signal,
+//	even though the lock is released before we sleep.  (Release
+//	won't give up the CPU while interrupts are disabled.)
 //
 //	Note: we assume Mesa-style semantics, which means that the
 //	waiter must re-acquire the monitor lock when waking up.
@@ -230,16 +429,23 @@ Condition::~Condition() {
 //----------------------------------------------------------------------
 
 void Condition::Wait(Lock *conditionLock) {
-    Semaphore *waiter;
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
 
     ASSERT(conditionLock->IsHeldByCurrentThread());
 
-    waiter = new Semaphore("condition", 0);
-    waitQueue->Append(waiter);
+    // disable interrupts
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    currentThread->UpdateBurstEstimate();  // before we are ranked
+    waitQueue->Append(currentThread);
     conditionLock->Release();
-    waiter->P();
+    currentThread->Sleep(FALSE);
+
+    // re-enable interrupts
+    (void)interrupt->SetLevel(oldLevel);
+
     conditionLock->Acquire();
-    delete waiter;
 }
 
 //----------------------------------------------------------------------
@@ -251,21 +457,25 @@ void Condition::Wait(Lock *conditionLock) {
 //	being woken up (unlike Hoare-style).
 //
 //	Also note: we assume the caller holds the monitor lock
-//	(unlike what is described in Birrell's paper).  This allows
-//	us to access waitQueue without disabling interrupts.
+//	(unlike what is described in Birrell's paper).  We still
+//	disable interrupts, because waking up the thread puts it on
+//	the ready list.
 //
 //	"conditionLock" -- lock protecting the use of this condition
 //----------------------------------------------------------------------
 
 void Condition::Signal(Lock *conditionLock) {
-    Semaphore *waiter;
-
     ASSERT(conditionLock->IsHeldByCurrentThread());
 
+    // disable interrupts
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
     if (!waitQueue->IsEmpty()) {
-        waiter = waitQueue->RemoveFront();
-        waiter->V();
+        kernel->scheduler->ReadyToRun(waitQueue->RemoveFront());
     }
+
+    // re-enable interrupts
+    (void)kernel->interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
@@ -280,3 +490,204 @@ void Condition::Broadcast(Lock *conditionLock) {
         Signal(conditionLock);
     }
 }
+
+//----------------------------------------------------------------------
+// ReaderWriterLock::ReaderWriterLock
+// 	Initialize a reader-writer lock, so that it can be used for
+//	synchronization.  Initially, no one holds it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"policy" -- whether waiting writers hold off new readers, or
+//		everyone waits their turn
+//----------------------------------------------------------------------
+
+ReaderWriterLock::ReaderWriterLock(char *debugName, RWLockPolicy policy) {
+    name = debugName;
+    this->policy = policy;
+    lock = new Lock("rw lock");
+    readOK = new Condition("rw read ok");
+    writeOK = new Condition("rw write ok");
+    activeReaders = 0;
+    writing = FALSE;
+    waitingWriters = 0;
+    nextTicket = nowServing = 0;
+}
+
+//----------------------------------------------------------------------
+// ReaderWriterLock::~ReaderWriterLock
+// 	Deallocate a reader-writer lock.  No one may still hold it,
+//	or be waiting for it.
+//----------------------------------------------------------------------
+
+ReaderWriterLock::~ReaderWriterLock() {
+    ASSERT(activeReaders == 0 && !writing);
+    delete lock;
+    delete readOK;
+    delete writeOK;
+}
+
+//----------------------------------------------------------------------
+// ReaderWriterLock::AcquireRead
+// 	Wait until the lock may be shared, then join the other readers.
+//
+//	If writers are preferred, a reader waits while anyone is writing,
+//	or waiting to write.  If the lock is fair, a reader waits for its
+//	turn, and for the writer before it to finish; once in, it lets
+//	the next thread in line check whether it may come in too.
+//----------------------------------------------------------------------
+
+void ReaderWriterLock::AcquireRead() {
+    lock->Acquire();
+    if (policy == RWPreferWriters) {
+        while (writing || waitingWriters > 0) {
+            readOK->Wait(lock);
+        }
+    } else {
+        int ticket = nextTicket++;
+
+        while (ticket != nowServing || writing) {
+            readOK->Wait(lock);
+        }
+        nowServing++;
+        readOK->Broadcast(lock);
+    }
+    activeReaders++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ReaderWriterLock::ReleaseRead
+// 	Leave the readers.  The last reader out lets a writer in.
+//----------------------------------------------------------------------
+
+void ReaderWriterLock::ReleaseRead() {
+    lock->Acquire();
+    ASSERT(activeReaders > 0);
+    activeReaders--;
+    if (activeReaders == 0) {
+        if (policy == RWPreferWriters) {
+            writeOK->Signal(lock);
+        } else {
+            readOK->Broadcast(lock);
+        }
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ReaderWriterLock::AcquireWrite
+// 	Wait until no one else holds the lock (and, if the lock is fair,
+//	until every thread that arrived earlier has had its turn), then
+//	hold it alone.
+//----------------------------------------------------------------------
+
+void ReaderWriterLock::AcquireWrite() {
+    lock->Acquire();
+    if (policy == RWPreferWriters) {
+        waitingWriters++;
+        while (writing || activeReaders > 0) {
+            writeOK->Wait(lock);
+        }
+        waitingWriters--;
+    } else {
+        int ticket = nextTicket++;
+
+        while (ticket != nowServing || writing || activeReaders > 0) {
+            readOK->Wait(lock);
+        }
+        nowServing++;
+    }
+    writing = TRUE;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ReaderWriterLock::ReleaseWrite
+// 	Give up the lock.  If writers are preferred, let the next writer
+//	in, if there is one, and otherwise all the waiting readers; if
+//	the lock is fair, let whoever is next in line in.
+//----------------------------------------------------------------------
+
+void ReaderWriterLock::ReleaseWrite() {
+    lock->Acquire();
+    ASSERT(writing);
+    writing = FALSE;
+    if (policy == RWPreferWriters && waitingWriters > 0) {
+        writeOK->Signal(lock);
+    } else {
+        readOK->Broadcast(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ReaderWriterLock::SelfTest, RWSelfTestReader, RWSelfTestWriter
+// 	Test both kinds of reader-writer lock, by forking readers and
+//	writers that yield while they hold the lock.  Check that a
+//	writer is always alone, and that readers did get to share.
+//----------------------------------------------------------------------
+
+static const int RWTestThreads = 9;  // readers and writers, 2 to 1
+static const int RWTestRounds = 5;   // times each one takes the lock
+
+static int rwReaders, rwWriters;  // threads holding the lock now
+static int rwMostReaders;         // most readers holding it at once
+static Semaphore *rwDone;         // V'ed by each thread as it finishes
+
+static void
+RWSelfTestReader(ReaderWriterLock *rwLock) {
+    for (int i = 0; i < RWTestRounds; i++) {
+        rwLock->AcquireRead();
+        ASSERT(rwWriters == 0);
+        rwReaders++;
+        rwMostReaders = max(rwMostReaders, rwReaders);
+        kernel->currentThread->Yield();
+        ASSERT(rwWriters == 0);
+        rwReaders--;
+        rwLock->ReleaseRead();
+        kernel->currentThread->Yield();
+    }
+    rwDone->V();
+}
+
+static void
+RWSelfTestWriter(ReaderWriterLock *rwLock) {
+    for (int i = 0; i < RWTestRounds; i++) {
+        rwLock->AcquireWrite();
+        ASSERT(rwReaders == 0 && rwWriters == 0);
+        rwWriters++;
+        kernel->currentThread->Yield();
+        ASSERT(rwReaders == 0 && rwWriters == 1);
+        rwWriters--;
+        rwLock->ReleaseWrite();
+        kernel->currentThread->Yield();
+    }
+    rwDone->V();
+}
+
+void ReaderWriterLock::SelfTest() {
+    RWLockPolicy policies[] = {RWPreferWriters, RWFair};
+
+    rwDone = new Semaphore("rw done", 0);
+    for (int p = 0; p < 2; p++) {
+        ReaderWriterLock *rwLock = new ReaderWriterLock("rw test", policies[p]);
+
+        rwReaders = rwWriters = rwMostReaders = 0;
+        for (int i = 0; i < RWTestThreads; i++) {
+            Thread *t = new Thread("rw test", i + 1);
+
+            // two readers for every writer, readers first
+            if (i % 3 == 2) {
+                t->Fork((VoidFunctionPtr)RWSelfTestWriter, rwLock);
+            } else {
+                t->Fork((VoidFunctionPtr)RWSelfTestReader, rwLock);
+            }
+        }
+        for (int i = 0; i < RWTestThreads; i++) {
+            rwDone->P();
+        }
+        ASSERT(rwMostReaders > 1);
+        delete rwLock;
+    }
+    delete rwDone;
+}
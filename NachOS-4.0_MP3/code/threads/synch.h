@@ -18,10 +18,40 @@
 #define SYNCH_H
 
 #include "copyright.h"
+#include "heap.h"
 #include "list.h"
 #include "main.h"
 #include "thread.h"
 
+// The following class defines the queue of threads waiting on a
+// synchronization object.  Threads come off it in the order the
+// scheduling policy would run them -- under the multi-level feedback
+// queue, by level, then by burst time (L1) or priority (L2), then
+// first come, first served -- so that a wakeup goes to the thread the
+// scheduler most wants to run.  Each thread is ranked as it stands
+// when it starts to wait; Reposition ranks it again.
+//
+// The queue is a heap, so adding or removing a thread takes O(log n)
+// time.  Interrupts must be disabled whenever it is used.
+
+class WaitQueue {
+   public:
+    WaitQueue();
+    ~WaitQueue();
+
+    void Append(Thread *thread);      // rank a thread, and queue it
+    Thread *RemoveFront();            // take off the best-ranked thread
+    void Reposition(Thread *thread);  // rank a waiting thread again
+    bool IsEmpty() { return heap->IsEmpty(); }
+    void Apply(void (*f)(Thread *)) const { heap->Apply(f); }
+                                      // apply to every waiting thread,
+                                      // in no particular order
+
+   private:
+    Heap<Thread *> *heap;  // waiting threads, best ranked first
+    int numAppended;       // threads queued so far
+};
+
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
 //
@@ -50,7 +80,7 @@ class Semaphore {
    private:
     char *name;  // useful for debugging
     int value;   // semaphore value, always >= 0
-    List<Thread *> *queue;
+    WaitQueue *queue;
     // threads waiting in P() for the value to be > 0
 };
 
@@ -65,6 +95,12 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).
+//
+// Locks implement priority inheritance: while a thread waits for a
+// lock, the holder runs with the waiter's priority if that is higher,
+// and so does whatever thread the holder is itself waiting for, and
+// so on down the chain.  Release gives the lock straight to the
+// waiter the scheduler ranks first (see WaitQueue).
 
 class Lock {
    public:
@@ -84,9 +120,16 @@ class Lock {
     // Note: SelfTest routine provided by SynchList
 
    private:
-    char *name;            // debugging assist
-    Thread *lockHolder;    // thread currently holding lock
-    Semaphore *semaphore;  // we use a semaphore to implement lock
+    char *name;              // debugging assist
+    Thread *lockHolder;      // thread currently holding lock
+    WaitQueue *waiters;      // threads waiting in Acquire
+    Lock *nextHeld;          // next lock held by lockHolder
+
+    int TopWaiterPriority();  // highest priority of the waiters,
+                              // -1 if none
+    static void Donate(Thread *thread, int priority);
+                              // lend "priority" to "thread", and
+                              // whoever it is waiting for
 };
 
 // The following class defines a "condition variable".  A condition
@@ -140,6 +183,53 @@ class Condition {
 
    private:
     char *name;
-    List<Semaphore *> *waitQueue;  // list of waiting threads
+    WaitQueue *waitQueue;  // threads waiting to be signalled
+};
+
+// The following class defines a "reader-writer lock".  Any number of
+// threads may hold it for reading at once, but a thread holding it for
+// writing holds it alone:
+//
+//	AcquireRead/ReleaseRead -- share the lock with other readers
+//
+//	AcquireWrite/ReleaseWrite -- hold the lock exclusively
+//
+// The two variants differ in who goes first when both readers and
+// writers are waiting.  A "writer-preferring" lock makes new readers
+// wait as long as any writer is waiting, so that writers can't be
+// starved by a stream of readers (but readers can be starved by a
+// stream of writers).  A "fair" lock lets threads in in the order they
+// arrived, admitting readers that arrive together as a group.
+//
+// It is built out of a Lock and condition variables, and so, like them,
+// works only with other kernel threads.
+
+enum RWLockPolicy { RWPreferWriters,  // readers wait for waiting writers
+                    RWFair };         // first come, first served
+
+class ReaderWriterLock {
+   public:
+    ReaderWriterLock(char *debugName, RWLockPolicy policy);
+    ~ReaderWriterLock();
+    char *getName() { return name; }
+
+    void AcquireRead();   // wait until no one is writing
+    void ReleaseRead();
+    void AcquireWrite();  // wait until no one is reading or writing
+    void ReleaseWrite();
+
+    static void SelfTest();  // test routine for reader-writer locks
+
+   private:
+    char *name;
+    RWLockPolicy policy;
+    Lock *lock;           // protects the fields below
+    Condition *readOK;    // readers (or, if fair, everyone) wait here
+    Condition *writeOK;   // writers wait here, if writers are preferred
+    int activeReaders;    // threads holding the lock for reading
+    bool writing;         // is a thread holding the lock for writing?
+    int waitingWriters;   // writers waiting for the lock
+    int nextTicket;       // fair lock: ticket for the next arrival
+    int nowServing;       // fair lock: ticket of the next to get in
 };
 #endif  // SYNCH_H
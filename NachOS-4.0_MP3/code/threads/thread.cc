@@ -25,6 +25,63 @@
 // this is put at the top of the execution stack, for detecting stack overflows
 const int STACK_FENCEPOST = 0xdedbeef;
 
+// Thread objects and stacks of finished threads, ready for reuse.
+// A guarded stack costs two host system calls (mprotect) to set up,
+// so it pays to keep a few rather than give them back.
+static void *threadPool[ThreadPoolSize];
+static int numPooledThreads = 0;
+static int *stackPool[ThreadPoolSize];
+static int numPooledStacks = 0;
+static int numStacksReused = 0;  // stacks handed out from the pool
+
+//----------------------------------------------------------------------
+// Thread::operator new, Thread::operator delete
+// 	Allocate a Thread from the pool if there is one there, and put
+//	a deleted Thread back in the pool unless the pool is full.
+//----------------------------------------------------------------------
+
+void *
+Thread::operator new(size_t size) {
+    ASSERT(size == sizeof(Thread));
+    if (numPooledThreads > 0) {
+        return threadPool[--numPooledThreads];
+    }
+    return ::operator new(size);
+}
+
+void Thread::operator delete(void *ptr, size_t size) {
+    ASSERT(size == sizeof(Thread));
+    if (numPooledThreads < ThreadPoolSize) {
+        threadPool[numPooledThreads++] = ptr;
+    } else {
+        ::operator delete(ptr);
+    }
+}
+
+//----------------------------------------------------------------------
+// AllocStack, FreeStack
+// 	Get an execution stack, with guard pages on either side, from
+//	the pool if there is one there; and give one back.
+//----------------------------------------------------------------------
+
+static int *
+AllocStack() {
+    if (numPooledStacks > 0) {
+        numStacksReused++;
+        return stackPool[--numPooledStacks];
+    }
+    return (int *)AllocBoundedArray(StackSize * sizeof(int));
+}
+
+static void
+FreeStack(int *stack) {
+    if (numPooledStacks < ThreadPoolSize) {
+        stackPool[numPooledStacks++] = stack;
+    } else {
+        DeallocBoundedArray((char *)stack, StackSize * sizeof(int));
+    }
+}
+
 //----------------------------------------------------------------------
 //	Thread::Fork.
 //
@@ -48,6 +105,19 @@ Thread::Thread(char *threadName, int threadID) {
     burstTime = 0;
     approxBurstTime = 0;
     shouldPreempt = FALSE;
+    agingIndex = -1;
+    readySeq = 0;
+    readyKey = 0;
+    queueIndex = -1;
+    cpu = -1;
+    runTicks = dispatchTick = chargedTicks = vruntime = 0;
+    createTick = readySince = waitTicks = 0;
+    inheritedPriority = -1;
+    waitingFor = NULL;
+    locksHeld = NULL;
+    waitLevel = waitKey = waitSeq = 0;
+    waitIndex = -1;
+    priority = 0;
 }
 
 //----------------------------------------------------------------------
@@ -66,7 +136,9 @@ Thread::~Thread() {
     DEBUG(dbgThread, "Deleting thread: " << name);
     ASSERT(this != kernel->currentThread);
     if (stack != NULL)
-        DeallocBoundedArray((char *)stack, StackSize * sizeof(int));
+        FreeStack(stack);
+    if (space != NULL)
+        delete space;  // give back its memory
 }
 
 //----------------------------------------------------------------------
@@ -98,6 +170,7 @@ void Thread::Fork(VoidFunctionPtr func, void *arg) {
     StackAllocate(func, arg);
 
     oldLevel = interrupt->SetLevel(IntOff);
+    createTick = kernel->stats->totalTicks;
     scheduler->ReadyToRun(this);  // ReadyToRun assumes that interrupts
                                   // are disabled!
     (void)interrupt->SetLevel(oldLevel);
@@ -159,6 +232,7 @@ void Thread::Begin() {
 //	or the execution stack, because we're still running in the thread
 //	and we're still on the stack!  Instead, we tell the scheduler
 //	to call the destructor, once it is running in the context of a different thread.
+//	The address space is not needed any more, so it goes right away.
 //
 // 	NOTE: we disable interrupts, because Sleep() assumes interrupts
 //	are disabled.
@@ -170,12 +244,21 @@ void Thread::Finish() {
     ASSERT(this == kernel->currentThread);
 
     DEBUG(dbgThread, "Finishing thread: " << name);
+    kernel->stats->numThreadsFinished++;
+    TRACE(TraceFinish, ID, 0);
+    kernel->stats->totalTurnaround += kernel->stats->totalTicks - createTick;
+    kernel->stats->totalWaiting += waitTicks;
     if (kernel->execExit && this->getIsExec()) {
         kernel->execRunningNum--;
         if (kernel->execRunningNum == 0) {
             kernel->interrupt->Halt();
         }
     }
+    if (space != NULL) {  // give back its memory now, rather than
+        delete space;     // when the thread is deleted
+        space = NULL;
+    }
+    UpdateBurstEstimate();
     Sleep(TRUE);  // invokes SWITCH
     // not reached
 }
@@ -206,6 +289,15 @@ void Thread::Yield() {
 
     DEBUG(dbgThread, "Yielding thread: " << name);
 
+    if (kernel->scheduler->RotatePending()) {  // our CPU's turn is up
+        kernel->scheduler->Rotate();
+        if (!kernel->scheduler->ShouldPreempt()) {
+            (void)kernel->interrupt->SetLevel(oldLevel);
+            return;
+        }
+        kernel->scheduler->CountPreemption();
+    }
+
     nextThread = kernel->scheduler->FindNextToRun();
     if (nextThread != NULL) {
 	
@@ -217,6 +309,29 @@ void Thread::Yield() {
     (void)kernel->interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Thread::UpdateBurstEstimate
+// 	The current thread is about to block (or finish), which ends its
+//	CPU burst.  Fold the time it ran into the estimate of its next
+//	burst, and start counting again.
+//
+//	Called before the thread joins a wait queue, since the queue
+//	may rank it by the new estimate, and before Thread::Sleep.
+//----------------------------------------------------------------------
+
+void Thread::UpdateBurstEstimate() {
+    ASSERT(this == kernel->currentThread);
+
+    // update accTime, renew burstTime reset accTime
+    this->accTime += (kernel->stats->totalTicks - this->lastTick);
+    int newApproxBurstTime = 0.5*this->approxBurstTime + 0.5*this->accTime;
+    DEBUG(dbgScheduler, "[D] Tick [" << kernel->stats->totalTicks << "]: Thread [" << this->getID() << "] update approximate burst time, from: [" << approxBurstTime << "], add [" << accTime << "], to ["<< newApproxBurstTime <<"]");
+    this->approxBurstTime = newApproxBurstTime;
+    this->burstTime = this->approxBurstTime - this->accTime;
+    this->accTime = 0;
+    // this->lastTick = kernel->stats->totalTicks;
+}
+
 //----------------------------------------------------------------------
 // Thread::Sleep
 // 	Relinquish the CPU, because the current thread has either
@@ -236,6 +351,9 @@ void Thread::Yield() {
 //	disable interrupts for atomicity.   We need interrupts off
 //	so that there can't be a time slice between pulling the first thread
 //	off the ready list, and switching to it.
+//
+//	The caller must have ended the thread's burst with
+//	UpdateBurstEstimate.
 //----------------------------------------------------------------------
 void Thread::Sleep(bool finishing) {
     Thread *nextThread;
@@ -246,18 +364,11 @@ void Thread::Sleep(bool finishing) {
     DEBUG(dbgThread, "Sleeping thread: " << name);
     DEBUG(dbgTraCode, "In Thread::Sleep, Sleeping thread: " << name << ", " << kernel->stats->totalTicks);
 
-    // update accTime, renew burstTime reset accTime
-    this->accTime += (kernel->stats->totalTicks - this->lastTick);
-    int newApproxBurstTime = 0.5*this->approxBurstTime + 0.5*this->accTime;
-    DEBUG(dbgScheduler, "[D] Tick [" << kernel->stats->totalTicks << "]: Thread [" << this->getID() << "] update approximate burst time, from: [" << approxBurstTime << "], add [" << accTime << "], to ["<< newApproxBurstTime <<"]");
-    this->approxBurstTime = newApproxBurstTime;
-    this->burstTime = this->approxBurstTime - this->accTime;
-    this->accTime = 0;
-    // this->lastTick = kernel->stats->totalTicks;
-
     status = BLOCKED;
     // cout << "debug Thread::Sleep " << name << "wait for Idle\n";
-    while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL) {
+    while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL &&
+           (nextThread = kernel->scheduler->FindBusyCPU()) == NULL) {
+        kernel->scheduler->ReclaimZombies();  // nothing better to do
         kernel->interrupt->Idle();  // no one to run, wait for an interrupt
     }
     // returns when it's time for us to run
@@ -312,7 +423,7 @@ PLabelToAddr(void *plabel) {
 //----------------------------------------------------------------------
 
 void Thread::StackAllocate(VoidFunctionPtr func, void *arg) {
-    stack = (int *)AllocBoundedArray(StackSize * sizeof(int));
+    stack = AllocStack();
 
 #ifdef PARISC
     // HP stack works from low addresses to high addresses
@@ -431,3 +542,46 @@ void Thread::SelfTest() {
     kernel->currentThread->Yield();
     SimpleThread(0);
 }
+
+//----------------------------------------------------------------------
+// ForkJoinThread
+// 	Body of each thread forked by Thread::ForkJoinTest: just finish.
+//----------------------------------------------------------------------
+
+static bool joined;  // has the last thread forked finished?
+
+static void
+ForkJoinThread(int which) {
+    joined = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Thread::ForkJoinTest
+// 	Fork "numThreads" threads one after the other, waiting for each
+//	to finish before forking the next, so that each new thread can
+//	reuse the Thread and stack of the one before.  Print how many
+//	threads, in real time, can be created and finished per second.
+//----------------------------------------------------------------------
+
+void Thread::ForkJoinTest(int numThreads) {
+    int reused = numStacksReused;
+    double start, finish;
+    Thread *t;
+
+    DEBUG(dbgThread, "Entering Thread::ForkJoinTest");
+
+    start = HostTime();
+    for (int i = 0; i < numThreads; i++) {
+        joined = FALSE;
+        t = new Thread("fork join thread", i + 1);
+        t->Fork((VoidFunctionPtr)ForkJoinThread, (void *)i);
+        while (!joined) {
+            kernel->currentThread->Yield();
+        }
+    }
+    finish = HostTime();
+
+    cout << "Fork/join self test: " << numThreads << " threads, "
+         << numThreads / (finish - start) << " threads per second, "
+         << numStacksReused - reused << " stacks reused\n";
+}
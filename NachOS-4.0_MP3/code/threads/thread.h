@@ -43,6 +43,8 @@
 #include "sysdep.h"
 #include "utility.h"
 
+class Lock;
+
 // CPU register state to be saved on context switch.
 // The x86 needs to save only a few registers,
 // SPARC and MIPS needs to save 10 registers,
@@ -56,6 +58,11 @@
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 const int StackSize = (8 * 1024);  // in words
 
+// How many finished threads, and how many of their stacks, are kept
+// around to be handed out again by "new Thread" and Fork, instead of
+// going back to the host.
+const int ThreadPoolSize = 64;
+
 // Thread state
 enum ThreadStatus { JUST_CREATED,
                     RUNNING,
@@ -88,6 +95,10 @@ class Thread {
                                             // must not be running when delete
                                             // is called
 
+    void *operator new(size_t size);     // take a Thread from the pool
+    void operator delete(void *ptr, size_t size);
+                                         // put a Thread back in the pool
+
     // basic thread operations
 
     void Fork(VoidFunctionPtr func, void *arg);
@@ -96,6 +107,8 @@ class Thread {
                                  // other thread is runnable
     void Sleep(bool finishing);  // Put the thread to sleep and
                                  // relinquish the processor
+    void UpdateBurstEstimate();  // The CPU burst is over; fold it
+                                 // into the estimate of the next one
     void Begin();                // Startup code for the thread
     void Finish();               // The thread is done executing
 
@@ -108,17 +121,44 @@ class Thread {
     void setIsExec() { this->isExec = true; }
     bool getIsExec() { return (isExec); }
     void setBurstTime(int bt){burstTime=bt;}
-    int getBurstTime(){burstTime = approxBurstTime - accTime; return burstTime;}
+    int getBurstTime(){return approxBurstTime - accTime;}
     void Print() { cout << name; }
     void setPriority(int threadPriority){priority = threadPriority;}
-    int getPriority(){ return (priority);}
+    int getPriority(){ return max(priority, inheritedPriority);}
+				// including any inherited from
+				// threads waiting for our locks
+    int getBasePriority(){ return (priority);}
     void updateLastTick(int tick){lastTick = tick;};
     void SelfTest();  // test whether thread impl is working
+    static void ForkJoinTest(int numThreads);
+                      // time thread creation and exit
     int accTime; // accumulate running time.
     int lastTick; // for calculating accTime
     int approxBurstTime;
     int burstTime; // burst time for scheduler
     bool shouldPreempt;   
+    int agingIndex; // position in the scheduler's aging queue,
+                    // -1 if not ready
+    int readySeq;   // order in which the thread joined the ready queue
+    int readyKey;   // what L1 or L2 is sorted on, saved when queued
+    int queueIndex; // position in L1 or L2, -1 if not there
+    int cpu;        // CPU the thread last ran on, or is queued on;
+                    // -1 if neither
+    int runTicks;     // CPU time used so far
+    int dispatchTick; // when the thread was last given a CPU
+    int chargedTicks; // part of runTicks added to vruntime
+    int vruntime;     // virtual time (CFS) or pass (stride)
+    int createTick;   // when the thread was forked
+    int readySince;   // when the thread last joined the ready queue
+    int waitTicks;    // time spent on the ready queue so far
+    int inheritedPriority;  // highest priority of the threads waiting
+                            // for locks we hold, -1 if none
+    Lock *waitingFor;       // lock we are waiting to acquire, if any
+    Lock *locksHeld;        // locks we hold, linked through the locks
+    int waitLevel;  // how the scheduler ranked the thread when it
+    int waitKey;    // started to wait on a synchronization object
+    int waitSeq;    // order in which it started to wait there
+    int waitIndex;  // position in the wait queue, -1 if not there
 private:
     // some of the private data for this class is listed above
 
@@ -0,0 +1,86 @@
+// trace.cc
+//	Routines to record scheduler events in a ring buffer, and to
+//	write them out when Nachos halts.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "trace.h"
+
+#include "copyright.h"
+#include "main.h"
+#include "sysdep.h"
+
+//----------------------------------------------------------------------
+// Tracer::Tracer
+// 	Set up an empty ring, if we are tracing.
+//
+//	"traceFile" -- where to write the trace at halt, or NULL
+//----------------------------------------------------------------------
+
+Tracer::Tracer(char *traceFile) {
+    fileName = traceFile;
+    events = (traceFile != NULL) ? new TraceEvent[TraceSize] : NULL;
+    next = 0;
+    numRecorded = 0;
+}
+
+//----------------------------------------------------------------------
+// Tracer::~Tracer
+// 	Nachos is halting: write out the trace.
+//----------------------------------------------------------------------
+
+Tracer::~Tracer() {
+    if (events != NULL) {
+        Export();
+        delete[] events;
+    }
+}
+
+//----------------------------------------------------------------------
+// Tracer::Record
+// 	Put an event in the next slot of the ring, overwriting the oldest
+//	event once the ring is full.
+//
+//	"type" -- what happened
+//	"thread" -- the ID of the thread it happened to
+//	"arg" -- more about the event; see tracefmt.h
+//----------------------------------------------------------------------
+
+void Tracer::Record(TraceType type, int thread, int arg) {
+    TraceEvent *event = &events[next];
+
+    event->tick = kernel->stats->totalTicks;
+    event->thread = thread;
+    event->arg = arg;
+    event->type = type;
+    event->cpu = kernel->scheduler->CurrentCPU();
+    next = (next + 1) & (TraceSize - 1);
+    numRecorded++;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Export
+// 	Write the events still in the ring to the trace file, oldest
+//	first, after a header saying how many there are and how many
+//	were lost.
+//----------------------------------------------------------------------
+
+void Tracer::Export() {
+    TraceHeader header;
+    int fd;
+
+    header.magic = TRACE_MAGIC;
+    header.version = TRACE_VERSION;
+    header.numEvents = min(numRecorded, TraceSize);
+    header.numDropped = numRecorded - header.numEvents;
+
+    fd = OpenForWrite(fileName);
+    WriteFile(fd, (char *)&header, sizeof(header));
+    if (numRecorded >= TraceSize) {  // the ring has wrapped around
+        WriteFile(fd, (char *)&events[next], (TraceSize - next) * sizeof(TraceEvent));
+    }
+    WriteFile(fd, (char *)events, next * sizeof(TraceEvent));
+    Close(fd);
+}
@@ -0,0 +1,52 @@
+// trace.h
+//	Data structures for tracing scheduler events.
+//
+//	The tracer keeps the most recent TraceSize events in a ring
+//	buffer, as fixed-size binary records, and writes them to a file
+//	when Nachos halts.  Recording an event just fills in a record:
+//	nothing is formatted, so tracing is cheap enough to leave on
+//	while measuring.  The file is read by the tracestat tool.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+#include "tracefmt.h"
+#include "utility.h"
+
+const int TraceSize = 64 * 1024;  // events kept; must be a power of 2
+
+class Tracer {
+   public:
+    Tracer(char *traceFile);  // trace to "traceFile";
+                              // NULL to trace nothing
+    ~Tracer();                // write out the trace
+
+    bool IsEnabled() { return events != NULL; }
+    void Record(TraceType type, int thread, int arg);
+    // Add an event to the ring
+
+   private:
+    char *fileName;       // where to write the trace
+    TraceEvent *events;   // the ring; NULL if not tracing
+    int next;             // slot for the next event
+    int numRecorded;      // events recorded so far
+
+    void Export();        // write the ring to "fileName"
+};
+
+//----------------------------------------------------------------------
+// TRACE
+//      If tracing, record an event.  Cheap to test, like DEBUG.
+//----------------------------------------------------------------------
+#define TRACE(type, thread, arg)                         \
+    if (!kernel->tracer->IsEnabled()) {                  \
+    } else {                                             \
+        kernel->tracer->Record((type), (thread), (arg)); \
+    }
+
+#endif  // TRACE_H
@@ -0,0 +1,46 @@
+// tracefmt.h
+//	Layout of the scheduler trace file written by Nachos ("-tr")
+//	and read by the tracestat tool.  Plain C, so that both can
+//	include it.
+//
+//	A trace file is a TraceHeader followed by "numEvents" TraceEvents,
+//	oldest first, in the byte order of the host that wrote it.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACEFMT_H
+#define TRACEFMT_H
+
+#define TRACE_MAGIC 0x4e545243  // "NTRC"
+#define TRACE_VERSION 1
+
+// The events that are traced.  "thread" and "arg" in each event
+// mean:
+enum TraceType {
+    TraceEnqueue = 1,  // thread put on a ready queue; arg = its CPU
+    TraceDequeue,      // thread taken off to run; arg = its CPU
+    TraceSwitch,       // thread given the CPU; arg = thread it replaced
+    TraceAging,        // thread's priority raised; arg = new priority
+    TracePreempt,      // timer preempts thread; arg = its MLFQ level
+    TraceFinish        // thread finished; arg unused
+};
+
+typedef struct {
+    int magic;       // TRACE_MAGIC
+    int version;     // TRACE_VERSION
+    int numEvents;   // events in the file
+    int numDropped;  // older events overwritten before the file
+                     // was written
+} TraceHeader;
+
+typedef struct {
+    int tick;      // kernel->stats->totalTicks when it happened
+    int thread;    // ID of the thread it happened to
+    int arg;       // depends on the type, see above
+    short type;    // a TraceType
+    short cpu;     // CPU that had the Machine
+} TraceEvent;
+
+#endif  // TRACEFMT_H
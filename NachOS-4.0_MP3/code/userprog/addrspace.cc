@@ -18,9 +18,9 @@
 #include "addrspace.h"
 
 #include "copyright.h"
+#include "frametable.h"
 #include "machine.h"
 #include "main.h"
-#include "noff.h"
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -54,156 +54,681 @@ SwapHeader(NoffHeader *noffH) {
 #endif
 }
 
+//----------------------------------------------------------------------
+// SegmentInPage
+// 	Return TRUE if any part of segment "seg" falls within virtual
+//	page "vpn".
+//----------------------------------------------------------------------
+
+static bool
+SegmentInPage(Segment *seg, int vpn) {
+    return seg->size > 0 && seg->virtualAddr < (vpn + 1) * PageSize &&
+           seg->virtualAddr + seg->size > vpn * PageSize;
+}
+
+//----------------------------------------------------------------------
+// LoadSegmentPages
+// 	Copy the part of segment "seg" that falls within the "count"
+//	virtual pages starting at "vpn" from the executable into the
+//	physically contiguous frames starting at "frame", with a single
+//	read.
+//----------------------------------------------------------------------
+
+static void
+LoadSegmentPages(OpenFile *executable, Segment *seg, int vpn, int count,
+                 int frame) {
+    int runStart = vpn * PageSize;
+    int start = max(seg->virtualAddr, runStart);
+    int end = min(seg->virtualAddr + seg->size, runStart + count * PageSize);
+
+    if (start < end) {
+        executable->ReadAt(
+            &(kernel->machine->mainMemory[frame * PageSize + start - runStart]),
+            end - start, seg->inFileAddr + start - seg->virtualAddr);
+    }
+}
+
+//----------------------------------------------------------------------
+// SharedImage::SharedImage
+// 	Set up the shared image of an executable, given the open file.
+//	No pages are read in until some address space maps them.
+//----------------------------------------------------------------------
+
+SharedImage::SharedImage(char *fileName, OpenFile *file) {
+    int end = 0;
+
+    name = new char[strlen(fileName) + 1];
+    strcpy(name, fileName);
+    executable = file;
+
+    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
+    if ((noffH.noffMagic != NOFFMAGIC) &&
+        (WordToHost(noffH.noffMagic) == NOFFMAGIC))
+        SwapHeader(&noffH);
+    ASSERT(noffH.noffMagic == NOFFMAGIC);
+
+    if (noffH.code.size > 0)
+        end = max(end, noffH.code.virtualAddr + noffH.code.size);
+    if (noffH.initData.size > 0)
+        end = max(end, noffH.initData.virtualAddr + noffH.initData.size);
+#ifdef RDATA
+    if (noffH.readonlyData.size > 0)
+        end = max(end, noffH.readonlyData.virtualAddr + noffH.readonlyData.size);
+#endif
+    numPages = divRoundUp(end, PageSize);
+    frames = new int[numPages];
+    for (int i = 0; i < numPages; i++)
+        frames[i] = -1;
+    users = new List<AddrSpace *>;
+}
+
+//----------------------------------------------------------------------
+// SharedImage::~SharedImage
+// 	Close the executable.  Every page must have been unmapped.
+//----------------------------------------------------------------------
+
+SharedImage::~SharedImage() {
+    for (int i = 0; i < numPages; i++)
+        ASSERT(frames[i] == -1);
+    delete executable;
+    delete[] name;
+    delete[] frames;
+    delete users;
+}
+
+//----------------------------------------------------------------------
+// SharedImage::Backs
+// 	Return TRUE if virtual page "vpn" is initialized from the
+//	executable (as opposed to being zero-filled).
+//----------------------------------------------------------------------
+
+bool SharedImage::Backs(int vpn) {
+    if (vpn >= numPages)
+        return FALSE;
+    if (SegmentInPage(&noffH.code, vpn) || SegmentInPage(&noffH.initData, vpn))
+        return TRUE;
+#ifdef RDATA
+    if (SegmentInPage(&noffH.readonlyData, vpn))
+        return TRUE;
+#endif
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// SharedImage::Writable
+// 	Return TRUE if virtual page "vpn" holds initialized data, and
+//	so may be written to (after it is copied).  A page that holds
+//	only code or read-only data stays read-only.
+//----------------------------------------------------------------------
+
+bool SharedImage::Writable(int vpn) {
+    return vpn < numPages && SegmentInPage(&noffH.initData, vpn);
+}
+
+//----------------------------------------------------------------------
+// SharedImage::MapPage
+// 	Return the frame holding shared page "vpn" for one more address
+//	space, reading the page in from the executable if it is not
+//	already in memory.
+//----------------------------------------------------------------------
+
+int SharedImage::MapPage(int vpn) {
+    int frame;
+
+    ASSERT(Backs(vpn));
+    if (frames[vpn] >= 0) {
+        kernel->frameTable->Share(frames[vpn]);
+        return frames[vpn];
+    }
+
+    frame = kernel->frameTable->AllocateShared(this, vpn);
+    ReadPages(1, &vpn, &frame);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// SharedImage::MapPages
+// 	Like MapPage, for the "count" pages starting at "vpn", storing
+//	the frames in "frameNums".  The pages that are not in memory are
+//	read in together, if there are enough free frames for all of
+//	them; otherwise, only the first page is mapped, evicting some
+//	other page if needed.  Return the number of pages mapped.
+//----------------------------------------------------------------------
+
+int SharedImage::MapPages(int vpn, int count, int *frameNums) {
+    int *missing = new int[count];
+    int *newFrames = new int[count];
+    int numMissing = 0;
+
+    for (int i = 0; i < count; i++) {
+        ASSERT(Backs(vpn + i));
+        if (frames[vpn + i] < 0)
+            missing[numMissing++] = vpn + i;
+    }
+    if (!kernel->frameTable->AllocateSharedBulk(this, numMissing, missing,
+                                                newFrames)) {
+        delete[] missing;
+        delete[] newFrames;
+        frameNums[0] = MapPage(vpn);
+        return 1;
+    }
+
+    ReadPages(numMissing, missing, newFrames);
+    for (int i = 0, j = 0; i < count; i++) {
+        if (j < numMissing && missing[j] == vpn + i) {
+            j++;  // new frame, already counted
+        } else {
+            kernel->frameTable->Share(frames[vpn + i]);
+        }
+        frameNums[i] = frames[vpn + i];
+    }
+    delete[] missing;
+    delete[] newFrames;
+    return count;
+}
+
+//----------------------------------------------------------------------
+// SharedImage::ReadPages
+// 	Read the "count" pages "vpns" in from the executable, into the
+//	frames "frameNums".  Runs of consecutive pages that landed in
+//	consecutive frames are read with one request per segment,
+//	rather than one per page.
+//----------------------------------------------------------------------
+
+void SharedImage::ReadPages(int count, int *vpns, int *frameNums) {
+    for (int i = 0; i < count;) {
+        int run = 1;
+
+        while (i + run < count && vpns[i + run] == vpns[i] + run &&
+               frameNums[i + run] == frameNums[i] + run)
+            run++;
+        DEBUG(dbgAddr, "Reading pages " << vpns[i] << ".." << vpns[i] + run - 1
+                                        << " into frame " << frameNums[i]);
+        bzero(&(kernel->machine->mainMemory[frameNums[i] * PageSize]),
+              run * PageSize);
+        LoadSegmentPages(executable, &noffH.code, vpns[i], run, frameNums[i]);
+        LoadSegmentPages(executable, &noffH.initData, vpns[i], run, frameNums[i]);
+#ifdef RDATA
+        LoadSegmentPages(executable, &noffH.readonlyData, vpns[i], run,
+                         frameNums[i]);
+#endif
+        for (int j = 0; j < run; j++)
+            frames[vpns[i + j]] = frameNums[i + j];
+        i += run;
+    }
+}
+
+//----------------------------------------------------------------------
+// SharedImage::UnmapPage
+// 	One address space no longer maps shared page "vpn"; the frame
+//	is given back when nobody does.  This only does bookkeeping, so
+//	it can be called without the paging lock.
+//----------------------------------------------------------------------
+
+void SharedImage::UnmapPage(int vpn) {
+    ASSERT(frames[vpn] >= 0);
+    if (kernel->frameTable->Free(frames[vpn]) == 0)
+        frames[vpn] = -1;
+}
+
+//----------------------------------------------------------------------
+// SharedImage::Evict
+// 	The frame holding shared page "vpn" is being taken away;
+//	invalidate the translation in every address space that maps it.
+//----------------------------------------------------------------------
+
+void SharedImage::Evict(int vpn) {
+    ListIterator<AddrSpace *> iter(users);
+
+    for (; !iter.IsDone(); iter.Next()) {
+        TranslationEntry *entry = iter.Item()->PageEntry(vpn);
+
+        if (entry->valid && entry->physicalPage == frames[vpn])
+            entry->valid = FALSE;
+    }
+    frames[vpn] = -1;
+}
+
+//----------------------------------------------------------------------
+// SharedImage::Referenced
+// 	Return TRUE if any address space mapping shared page "vpn" has
+//	used it since the use bits were last cleared.  If "clear" is
+//	TRUE, clear them now.
+//----------------------------------------------------------------------
+
+bool SharedImage::Referenced(int vpn, bool clear) {
+    ListIterator<AddrSpace *> iter(users);
+    bool used = FALSE;
+
+    for (; !iter.IsDone(); iter.Next()) {
+        TranslationEntry *entry = iter.Item()->PageEntry(vpn);
+
+        if (entry->valid && entry->physicalPage == frames[vpn]) {
+            used = used || entry->use;
+            if (clear)
+                entry->use = FALSE;
+        }
+    }
+    return used;
+}
+
+//----------------------------------------------------------------------
+// SharedImage::AddUser, SharedImage::RemoveUser
+// 	Keep track of the address spaces running this image, so
+//	that shared pages can be evicted from all of them.
+//----------------------------------------------------------------------
+
+void SharedImage::AddUser(AddrSpace *space) { users->Append(space); }
+
+bool SharedImage::RemoveUser(AddrSpace *space) {
+    users->Remove(space);
+    return users->IsEmpty();
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 // 	Create an address space to run a user program.
-//	Set up the translation from program memory to physical
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+//	The page table is set up when the program is loaded, since
+//	that is when we know how big the address space is.
 //----------------------------------------------------------------------
 
 AddrSpace::AddrSpace() {
-    pageTable = new TranslationEntry[NumPhysPages];
-    for (int i = 0; i < NumPhysPages; i++) {
-        pageTable[i].virtualPage = i;  // for now, virt page # = phys page #
-        pageTable[i].physicalPage = i;
-        pageTable[i].valid = TRUE;
-        pageTable[i].use = FALSE;
-        pageTable[i].dirty = FALSE;
-        pageTable[i].readOnly = FALSE;
-    }
-
-    // zero out the entire address space
-    bzero(kernel->machine->mainMemory, MemorySize);
+    pageTable = NULL;
+    pageSource = NULL;
+    writable = NULL;
+    swapSlots = NULL;
+    image = NULL;
+    numPages = 0;
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.
+// 	Dealloate an address space, giving back its frames and
+//	swap slots, and the frames set aside for pages it never copied.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace() {
-    for (int i = 0;i < numPages;i++){
-	kernel->usedFrames[pageTable[i].physicalPage] = FALSE;
-    } 
-    delete pageTable;
+    int *privateFrames = new int[numPages];
+    int numPrivate = 0;
+
+    for (unsigned int i = 0; i < numPages; i++) {
+        if (NumSwapPages == 0 && writable[i] && pageSource[i] == IMAGE_PAGE)
+            kernel->frameTable->Unreserve(1);
+        if (pageTable[i].valid) {
+            if (pageSource[i] == IMAGE_PAGE)
+                image->UnmapPage(i);
+            else
+                privateFrames[numPrivate++] = pageTable[i].physicalPage;
+        }
+        if (swapSlots[i] >= 0)
+            kernel->frameTable->FreeSwap(swapSlots[i]);
+    }
+    kernel->frameTable->FreeBulk(numPrivate, privateFrames);
+    delete[] privateFrames;
+    if (image != NULL)
+        kernel->frameTable->CloseImage(image, this);
+    delete[] pageTable;
+    delete[] pageSource;
+    delete[] writable;
+    delete[] swapSlots;
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::Load
 // 	Load a user program into memory from a file.
 //
-//	Assumes that the page table has been initialized, and that
-//	the object code file is in NOFF format.
+//	Pages initialized from the file are shared, read-only, with any
+//	other address space running the same executable.  Only the first
+//	few are mapped now; the rest are mapped on demand.  Every other
+//	page (uninitialized data and the stack) gets a private frame
+//	full of zeros the first time it is touched, so loading costs
+//	nothing for pages the program never uses.  Every page also gets
+//	a slot in the swap area, to hold a private copy of it if it is
+//	evicted.
+//
+//	Assumes that the object code file is in NOFF format.
 //
 //	"fileName" is the file containing the object code to load into memory
 //----------------------------------------------------------------------
 
 bool AddrSpace::Load(char *fileName) {
-    OpenFile *executable = kernel->fileSystem->Open(fileName);
-    NoffHeader noffH;
+    FrameTable *frameTable = kernel->frameTable;
+    NoffHeader *noffH;
     unsigned int size;
-
-    if (executable == NULL) {
+    int available;
+    int *vpns, *frames;
+    int numPrivate = 0;
+    int numCopies = 0;
+    bool bulk;
+
+    frameTable->LockPaging();
+    image = frameTable->OpenImage(fileName);
+    if (image == NULL) {
+        frameTable->UnlockPaging();
         cerr << "Unable to open file " << fileName << "\n";
         return FALSE;
     }
-
-    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
-    if ((noffH.noffMagic != NOFFMAGIC) &&
-        (WordToHost(noffH.noffMagic) == NOFFMAGIC))
-        SwapHeader(&noffH);
-    ASSERT(noffH.noffMagic == NOFFMAGIC);
+    noffH = image->getHeader();
 
 #ifdef RDATA
     // how big is address space?
-    size = noffH.code.size + noffH.readonlyData.size + noffH.initData.size +
-           noffH.uninitData.size + UserStackSize;
+    size = noffH->code.size + noffH->readonlyData.size + noffH->initData.size +
+           noffH->uninitData.size + UserStackSize;
     // we need to increase the size
     // to leave room for the stack
 #else
     // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size + UserStackSize;  // we need to increase the size
-                                                                                           // to leave room for the stack
+    size = noffH->code.size + noffH->initData.size + noffH->uninitData.size + UserStackSize;  // we need to increase the size
+                                                                                              // to leave room for the stack
 #endif
     numPages = divRoundUp(size, PageSize);
     DEBUG(dbgAddr, "number of frames to allocated to program: "<< numPages);
     size = numPages * PageSize;
-    ASSERT(numPages <= NumPhysPages);  // check we're not trying
-                                       // to run anything too big --
-                                       // at least until we have
-                                       // virtual memory
-
-	int frameIndex{0}, freeFrameNumber{0};
-	for (int i = 0;i < NumPhysPages && freeFrameNumber < numPages;i++){
-		freeFrameNumber += !kernel->usedFrames[i];
-	}
-	if (freeFrameNumber < numPages){
-		DEBUG(dbgAddr, "memory limit exception occurs: " << freeFrameNumber << ", "<< numPages);
-		ExceptionHandler(MemoryLimitException);
-	}
-	
-	for (int i = 0;i < numPages;i++){
-		while (kernel->usedFrames[frameIndex] && frameIndex < NumPhysPages){
-			frameIndex++;
-		}
-		// cout << "Assign " << i << " " << frameIndex << endl;
-		kernel->usedFrames[frameIndex] = TRUE;
-		pageTable[i].physicalPage = frameIndex;
-		pageTable[i].virtualPage = i;
-		pageTable[i].valid = TRUE;
-	        pageTable[i].use = FALSE;
-        	pageTable[i].dirty = FALSE;
-	        pageTable[i].readOnly = FALSE;
-	}    
 
+    // every page needs somewhere to live when it is evicted; without
+    // a swap area, every page has to stay in memory, and we set aside
+    // a frame for each page of data we may have to copy on write
+    if (NumSwapPages > 0) {
+        available = frameTable->NumFreeSwap();
+    } else {
+        available = frameTable->NumFree();
+        for (unsigned int i = 0; i < numPages; i++) {
+            if (image->Backs(i) && image->Writable(i))
+                numCopies++;
+        }
+    }
+    if (available < (int)numPages + numCopies) {
+        DEBUG(dbgAddr, "memory limit exception occurs: " << available << ", " << numPages);
+        frameTable->CloseImage(image, NULL);  // we never became a user
+        image = NULL;
+        numPages = 0;
+        frameTable->UnlockPaging();
+        ExceptionHandler(MemoryLimitException);
+        return FALSE;
+    }
+
+    pageTable = new TranslationEntry[numPages];
+    pageSource = new PageSource[numPages];
+    writable = new bool[numPages];
+    swapSlots = new int[numPages];
+    for (unsigned int i = 0; i < numPages; i++) {
+        pageTable[i].virtualPage = i;
+        pageTable[i].physicalPage = -1;
+        pageTable[i].valid = FALSE;
+        pageTable[i].use = FALSE;
+        pageTable[i].dirty = FALSE;
+        pageSource[i] = image->Backs(i) ? IMAGE_PAGE : ZERO_PAGE;
+        writable[i] = (pageSource[i] == ZERO_PAGE || image->Writable(i));
+        pageTable[i].readOnly = (pageSource[i] == IMAGE_PAGE);
+        swapSlots[i] = (NumSwapPages > 0) ? frameTable->AllocateSwap() : -1;
+    }
+    frameTable->Reserve(numCopies);
+    image->AddUser(this);
 
     DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
 
-    // then, copy in the code and data segments into memory
-    // Note: this code assumes that virtual address = physical address
-    
-    if (noffH.initData.size <= 0){noffH.code.virtualAddr = 0;}
-    int pageNum = noffH.code.virtualAddr / PageSize;
-    int Offset = noffH.code.virtualAddr % PageSize;
-    int physicalPage = pageTable[pageNum].physicalPage * PageSize + Offset;
-    if (noffH.code.size > 0) {
-        DEBUG(dbgAddr, "Initializing code segment.");
-        DEBUG(dbgAddr, noffH.code.virtualAddr << ", " << noffH.code.size);
-        executable->ReadAt(
-            &(kernel->machine->mainMemory[physicalPage]),
-            noffH.code.size, noffH.code.inFileAddr);
+    // then, map the start of the code; the rest of the code and data
+    // is read in as the program touches it, a few pages at a time, so
+    // the program can start running (and other programs can load)
+    // without waiting for all of it -- unless there is no swap area,
+    // in which case everything is brought in now (see below)
+    MapImagePages(0, (NumSwapPages > 0) ? LoadAheadPages : numPages);
+
+    // the rest is zero-filled when it is first touched -- unless there
+    // is no swap area to evict it to, in which case it has to be in
+    // memory from the start; get the frames all at once if we can
+    if (NumSwapPages == 0) {
+        vpns = new int[numPages];
+        frames = new int[numPages];
+        for (unsigned int i = 0; i < numPages; i++) {
+            if (pageSource[i] == ZERO_PAGE)
+                vpns[numPrivate++] = i;
+        }
+        bulk = frameTable->AllocateBulk(this, numPrivate, vpns, frames);
+        for (int i = 0; i < numPrivate; i++) {
+            int vpn = vpns[i];
+
+            ZeroFill(vpn, bulk ? frames[i] : frameTable->Allocate(this, vpn));
+        }
+        delete[] vpns;
+        delete[] frames;
     }
-    
-    if (noffH.initData.size <= 0){noffH.initData.virtualAddr = 0;}
-    pageNum = noffH.initData.virtualAddr / PageSize;
-    Offset = noffH.initData.virtualAddr % PageSize;
-    physicalPage = pageTable[pageNum].physicalPage * PageSize + Offset;
-    if (noffH.initData.size > 0) {
-        DEBUG(dbgAddr, "Initializing data segment.");
-        DEBUG(dbgAddr, noffH.initData.virtualAddr << ", " << noffH.initData.size);
-        executable->ReadAt(
-            &(kernel->machine->mainMemory[noffH.initData.virtualAddr]),
-            noffH.initData.size, noffH.initData.inFileAddr);
+
+    frameTable->UnlockPaging();
+    return TRUE;  // success
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ZeroFill
+// 	Clear "frame" and map virtual page "vpn" to it.  From now on
+//	the page is private, and lives in the swap area when evicted.
+//----------------------------------------------------------------------
+
+void AddrSpace::ZeroFill(int vpn, int frame) {
+    bzero(&(kernel->machine->mainMemory[frame * PageSize]), PageSize);
+    pageSource[vpn] = SWAP_PAGE;
+    pageTable[vpn].physicalPage = frame;
+    pageTable[vpn].valid = TRUE;
+    pageTable[vpn].dirty = TRUE;  // there is no copy in swap yet
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::MapImagePages
+// 	Map the shared pages among the "count" pages starting at "vpn"
+//	that are not mapped yet.  Each run of such pages is mapped with
+//	one call to SharedImage::MapPages, so that it is read in with as
+//	few requests as possible.  We stop early if memory is so short
+//	that pages had to be evicted.
+//
+//	The caller must hold the paging lock.
+//----------------------------------------------------------------------
+
+void AddrSpace::MapImagePages(int vpn, int count) {
+    int end = min(vpn + count, (int)numPages);
+    int *frames = new int[count];
+
+    while (vpn < end) {
+        int run = 0, mapped;
+
+        // find the next run of unmapped shared pages
+        while (vpn < end &&
+               (pageSource[vpn] != IMAGE_PAGE || pageTable[vpn].valid))
+            vpn++;
+        while (vpn + run < end && pageSource[vpn + run] == IMAGE_PAGE &&
+               !pageTable[vpn + run].valid)
+            run++;
+        if (run == 0)
+            break;
+
+        mapped = image->MapPages(vpn, run, frames);
+        for (int i = 0; i < mapped; i++) {
+            pageTable[vpn + i].physicalPage = frames[i];
+            pageTable[vpn + i].valid = TRUE;
+            pageTable[vpn + i].use = FALSE;
+            pageTable[vpn + i].dirty = FALSE;
+        }
+        if (mapped < run)
+            break;
+        vpn += run;
     }
-    //delete executable;  // close file
-    //return TRUE;    
+    delete[] frames;
+}
 
-#ifdef RDATA
-    if (noffH.initData.size <= 0){noffH.readonlyData.virtualAddr = 0;}
-    pageNum = noffH.readonlyData.virtualAddr / PageSize;
-    Offset = noffH.readonlyData.virtualAddr % PageSize;
-    physicalPage = pageTable[pageNum].physicalPage * PageSize + Offset;
-    if (noffH.readonlyData.size > 0) {
-        DEBUG(dbgAddr, "Initializing read only data segment.");
-        DEBUG(dbgAddr, noffH.readonlyData.virtualAddr << ", " << noffH.readonlyData.size);
-        executable->ReadAt(
-            &(kernel->machine->mainMemory[noffH.readonlyData.virtualAddr]),
-            noffH.readonlyData.size, noffH.readonlyData.inFileAddr);
+//----------------------------------------------------------------------
+// AddrSpace::PageFault
+// 	Bring virtual page "vpn" into memory: from the executable if
+//	it is still shared, as a page of zeros if it has never been
+//	touched, or from the swap area if it is private, evicting some
+//	other page if memory is full.  Called when the user program
+//	touches a page whose translation is not valid; on return, the
+//	faulting instruction is retried.
+//----------------------------------------------------------------------
+
+void AddrSpace::PageFault(int vpn) {
+    FrameTable *frameTable = kernel->frameTable;
+
+    ASSERT(vpn >= 0 && vpn < (int)numPages);
+    frameTable->LockPaging();
+    if (!pageTable[vpn].valid && pageSource[vpn] == ZERO_PAGE) {
+        DEBUG(dbgAddr, "Zero fill: page " << vpn);
+        ZeroFill(vpn, frameTable->Allocate(this, vpn));
+        pageTable[vpn].use = FALSE;
+    } else if (!pageTable[vpn].valid && pageSource[vpn] == IMAGE_PAGE) {
+        MapImagePages(vpn, LoadAheadPages);  // and the next few, too
+    } else if (!pageTable[vpn].valid) {
+        int frame = frameTable->Allocate(this, vpn);
+
+        ASSERT(swapSlots[vpn] >= 0);
+        frameTable->PageIn(swapSlots[vpn], frame);
+        pageTable[vpn].physicalPage = frame;
+        pageTable[vpn].valid = TRUE;
+        pageTable[vpn].use = FALSE;
+        pageTable[vpn].dirty = FALSE;  // backing copy is up to date
     }
-#endif
-    delete executable;  // close file
-    return TRUE;        // success
+    frameTable->UnlockPaging();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOnWrite
+// 	The user program wrote to shared page "vpn".  Copy the page
+//	into a frame of our own, and make it writable.  On return, the
+//	faulting instruction is retried.
+//
+//	Return FALSE, without doing anything, if the page holds only
+//	code or read-only data; the write is then an error.
+//----------------------------------------------------------------------
+
+bool AddrSpace::CopyOnWrite(int vpn) {
+    FrameTable *frameTable = kernel->frameTable;
+    char buffer[PageSize];
+    int frame;
+
+    ASSERT(vpn >= 0 && vpn < (int)numPages);
+    if (!writable[vpn])
+        return FALSE;
+    frameTable->LockPaging();
+    if (pageSource[vpn] == IMAGE_PAGE) {
+        DEBUG(dbgAddr, "Copy on write: page " << vpn);
+        if (!pageTable[vpn].valid)
+            pageTable[vpn].physicalPage = image->MapPage(vpn);
+        bcopy(&(kernel->machine->mainMemory[pageTable[vpn].physicalPage * PageSize]),
+              buffer, PageSize);
+        pageTable[vpn].valid = FALSE;
+        image->UnmapPage(vpn);
+
+        // without swap, Load set a frame aside for this
+        frame = (NumSwapPages > 0) ? frameTable->Allocate(this, vpn)
+                                   : frameTable->AllocateReserved(this, vpn);
+        bcopy(buffer, &(kernel->machine->mainMemory[frame * PageSize]), PageSize);
+        pageSource[vpn] = SWAP_PAGE;
+        pageTable[vpn].physicalPage = frame;
+        pageTable[vpn].valid = TRUE;
+        pageTable[vpn].readOnly = FALSE;
+        pageTable[vpn].use = TRUE;
+        pageTable[vpn].dirty = TRUE;  // there is no copy in swap yet
+    }
+    frameTable->UnlockPaging();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::UserPage
+// 	Return a pointer to virtual page "vpn" in main memory, faulting
+//	it in first if needed; if "writing" is TRUE, also make sure the
+//	page is not shared, and return NULL if it cannot be written to.
+//	The pointer is good until the thread next gives up the CPU.
+//----------------------------------------------------------------------
+
+char *AddrSpace::UserPage(int vpn, bool writing) {
+    TranslationEntry *entry = &pageTable[vpn];
+
+    // servicing a fault can block, giving other threads a chance to
+    // evict the page again, so check until it sticks
+    while (!entry->valid || (writing && entry->readOnly)) {
+        if (!entry->valid)
+            PageFault(vpn);
+        else if (!CopyOnWrite(vpn))
+            return NULL;
+    }
+    entry->use = TRUE;
+    if (writing)
+        entry->dirty = TRUE;
+    return &(kernel->machine->mainMemory[entry->physicalPage * PageSize]);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyIn, AddrSpace::CopyOut
+// 	Copy "size" bytes from user address "vaddr" into "buffer" in the
+//	kernel, or from "buffer" to "vaddr".  Return FALSE if the user
+//	address range is not part of the address space, or if CopyOut
+//	finds a page of code or read-only data in it.
+//----------------------------------------------------------------------
+
+bool AddrSpace::CopyIn(int vaddr, char *buffer, int size) {
+    while (size > 0) {
+        int vpn = vaddr / PageSize;
+        int offset = vaddr % PageSize;
+        int count = min(size, PageSize - offset);
+
+        if (vaddr < 0 || vpn >= (int)numPages)
+            return FALSE;
+        bcopy(UserPage(vpn, FALSE) + offset, buffer, count);
+        vaddr += count;
+        buffer += count;
+        size -= count;
+    }
+    return TRUE;
+}
+
+bool AddrSpace::CopyOut(int vaddr, char *buffer, int size) {
+    while (size > 0) {
+        int vpn = vaddr / PageSize;
+        int offset = vaddr % PageSize;
+        int count = min(size, PageSize - offset);
+
+        char *page;
+
+        if (vaddr < 0 || vpn >= (int)numPages)
+            return FALSE;
+        page = UserPage(vpn, TRUE);
+        if (page == NULL)
+            return FALSE;
+        bcopy(buffer, page + offset, count);
+        vaddr += count;
+        buffer += count;
+        size -= count;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyInString
+// 	Copy a null-terminated string from user address "vaddr" into
+//	"buffer", which holds "size" bytes.  Return FALSE if the string
+//	is not in the address space, or does not fit.
+//----------------------------------------------------------------------
+
+bool AddrSpace::CopyInString(int vaddr, char *buffer, int size) {
+    while (size > 0) {
+        int vpn = vaddr / PageSize;
+        int offset = vaddr % PageSize;
+        int count = min(size, PageSize - offset);
+        char *page, *end;
+
+        if (vaddr < 0 || vpn >= (int)numPages)
+            return FALSE;
+        page = UserPage(vpn, FALSE) + offset;
+        end = (char *)memchr(page, '\0', count);
+        if (end != NULL) {
+            bcopy(page, buffer, end - page + 1);
+            return TRUE;
+        }
+        bcopy(page, buffer, count);
+        vaddr += count;
+        buffer += count;
+        size -= count;
+    }
+    return FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -15,9 +15,75 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "list.h"
 #include "machine.h"
+#include "noff.h"
 
 #define UserStackSize 1024  // increase this as necessary!
+#define LoadAheadPages 8    // shared pages mapped at once, when
+                            // loading and on a page fault
+
+class AddrSpace;
+
+// Where the contents of a virtual page come from when it has to be
+// brought (back) into memory.
+
+enum PageSource {
+    IMAGE_PAGE,  // shared, read-only copy from the executable
+    ZERO_PAGE,   // not touched yet; filled with zeros on first use
+    SWAP_PAGE    // private copy, saved in the swap area
+};
+
+// The following class describes an executable file that is being
+// run by one or more address spaces.  Pages that are initialized
+// from the file (code, read-only data and initialized data) are
+// shared by all of them and mapped read-only; an address space
+// that writes to a page of initialized data gets its own copy of
+// it (copy-on-write).  Writing to code or read-only data is an
+// error.
+//
+// Shared pages are never modified, so they can be evicted by simply
+// invalidating every mapping, and reloaded from the file.
+//
+// All operations except UnmapPage and RemoveUser must be called with
+// the paging lock held.
+
+class SharedImage {
+   public:
+    SharedImage(char *fileName, OpenFile *executable);
+    ~SharedImage();  // Close the executable
+
+    char *getName() { return name; }
+    NoffHeader *getHeader() { return &noffH; }
+
+    bool Backs(int vpn);      // Is page "vpn" initialized from the file?
+    bool Writable(int vpn);   // Does page "vpn" hold initialized data?
+    int MapPage(int vpn);     // Return the frame holding page "vpn",
+                              // reading it in if it is not in memory
+    int MapPages(int vpn, int count, int *frameNums);  // Same, for
+                                                       // several pages
+    void UnmapPage(int vpn);  // An address space stops using page "vpn"
+    void Evict(int vpn);      // The frame holding page "vpn" is being
+                              // reclaimed; invalidate every mapping
+    bool Referenced(int vpn, bool clear);  // Has any address space used
+                                           // page "vpn" recently?
+
+    void AddUser(AddrSpace *space);     // Start/stop running this
+    bool RemoveUser(AddrSpace *space);  // image in "space"; returns
+                                        // TRUE if it was the last user
+    bool HasUsers() { return !users->IsEmpty(); }
+
+   private:
+    char *name;                // file name, used to find the image
+    OpenFile *executable;      // where shared pages are read from
+    NoffHeader noffH;          // layout of the executable
+    int numPages;              // pages that are backed by the file
+    int *frames;               // frame holding each page, or -1
+    List<AddrSpace *> *users;  // address spaces running this image
+
+    void ReadPages(int count, int *vpns, int *frameNums);
+                               // Read pages in from the executable
+};
 
 class AddrSpace {
    public:
@@ -40,15 +106,45 @@ class AddrSpace {
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
 
+    void PageFault(int vpn);    // Bring virtual page "vpn" back
+                                // into memory
+    bool CopyOnWrite(int vpn);  // Give this address space its own
+                                // copy of shared page "vpn"; FALSE
+                                // if the page is not writable
+
+    // Copy data between the kernel and this address space, paging
+    // in (and un-sharing) pages as needed.  Return FALSE if the
+    // user address is not valid, or (for CopyOut) not writable.
+    bool CopyIn(int vaddr, char *buffer, int size);
+    bool CopyOut(int vaddr, char *buffer, int size);
+    bool CopyInString(int vaddr, char *buffer, int size);
+
+    TranslationEntry *PageEntry(int vpn) { return &pageTable[vpn]; }
+    int SwapSlot(int vpn) { return swapSlots[vpn]; }
+    int Size() { return numPages * PageSize; }  // in bytes
+
    private:
-    static bool usedFrames[NumPhysPages];
     TranslationEntry *pageTable;  // Assume linear page table translation
                                   // for now!
+    PageSource *pageSource;       // Where each page comes from when
+                                  // it is not in memory
+    bool *writable;               // FALSE for pages that hold only
+                                  // code or read-only data
+    int *swapSlots;               // Where each page lives when it is
+                                  // saved in the swap area
+    SharedImage *image;           // The executable we are running
     unsigned int numPages;        // Number of pages in the virtual
                                   // address space
 
     void InitRegisters();  // Initialize user-level CPU registers,
                            // before jumping to user code
+
+    char *UserPage(int vpn, bool writing);  // Where page "vpn" is in
+                                            // main memory, or NULL
+    void ZeroFill(int vpn, int frame);      // Give page "vpn" a frame
+                                            // full of zeros
+    void MapImagePages(int vpn, int count);  // Map the shared pages
+                                             // among "count" pages
 };
 
 #endif  // ADDRSPACE_H
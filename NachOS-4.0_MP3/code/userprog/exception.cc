@@ -25,6 +25,11 @@
 #include "ksyscall.h"
 #include "main.h"
 #include "syscall.h"
+
+// longest string (e.g., a file name) that a system call will copy
+// in from a user program
+const int MaxUserString = 256;
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -80,8 +85,9 @@ void ExceptionHandler(ExceptionType which) {
                     DEBUG(dbgSys, "Message received.\n");
                     val = kernel->machine->ReadRegister(4);
                     {
-                        char *msg = &(kernel->machine->mainMemory[val]);
-                        cout << msg << endl;
+                        char msg[MaxUserString];
+                        if (kernel->currentThread->space->CopyInString(val, msg, MaxUserString))
+                            cout << msg << endl;
                     }
                     SysHalt();
                     ASSERTNOTREACHED();
@@ -89,9 +95,12 @@ void ExceptionHandler(ExceptionType which) {
                 case SC_Create:
                     val = kernel->machine->ReadRegister(4);
                     {
-                        char *filename = &(kernel->machine->mainMemory[val]);
+                        char filename[MaxUserString];
                         // cout << filename << endl;
-                        status = SysCreate(filename);
+                        if (kernel->currentThread->space->CopyInString(val, filename, MaxUserString))
+                            status = SysCreate(filename);
+                        else
+                            status = 0;
                         kernel->machine->WriteRegister(2, (int)status);
                     }
                     kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -135,8 +144,11 @@ void ExceptionHandler(ExceptionType which) {
 		    
 		    val = kernel->machine->ReadRegister(4);
 		    {
-			char *filename = &(kernel->machine->mainMemory[val]);
-			fileID = SysOpen(filename);
+			char filename[MaxUserString];
+			if (kernel->currentThread->space->CopyInString(val, filename, MaxUserString))
+			    fileID = SysOpen(filename);
+			else
+			    fileID = -1;
 			kernel->machine->WriteRegister(2, fileID);
 		    }
 	    	    DEBUG(dbgSys, fileID << " opened.\n");
@@ -160,13 +172,18 @@ void ExceptionHandler(ExceptionType which) {
       		    break;		    
                 case SC_Write:
 		    val = kernel->machine->ReadRegister(4);
-		    {
-		    	char *buffer = &(kernel->machine->mainMemory[val]);
-		    	numChar = kernel->machine->ReadRegister(5);
-  		    	fileID = kernel->machine->ReadRegister(6);
-		    	status = SysWrite(buffer, numChar, fileID);
-		    	kernel->machine->WriteRegister(2, (int) status);
+		    numChar = kernel->machine->ReadRegister(5);
+		    fileID = kernel->machine->ReadRegister(6);
+		    status = -1;
+		    // no bigger than the address space, before we allocate
+		    if (numChar >= 0 &&
+		        numChar <= kernel->currentThread->space->Size()) {
+		    	char *buffer = new char[numChar];
+		    	if (kernel->currentThread->space->CopyIn(val, buffer, numChar))
+		    	    status = SysWrite(buffer, numChar, fileID);
+		    	delete[] buffer;
 		    }
+		    kernel->machine->WriteRegister(2, (int) status);
 		    //cout << status << " of chars saved."  << endl;		    
 
 		    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -178,12 +195,18 @@ void ExceptionHandler(ExceptionType which) {
 
 		case SC_Read:
                     val = kernel->machine->ReadRegister(4);
-		    {
-                    	char *buffer = &(kernel->machine->mainMemory[val]);
-                    	numChar = kernel->machine->ReadRegister(5); 
-                    	fileID = kernel->machine->ReadRegister(6); 
+                    numChar = kernel->machine->ReadRegister(5);
+                    fileID = kernel->machine->ReadRegister(6);
+                    status = -1;
+                    if (numChar >= 0 &&
+                        numChar <= kernel->currentThread->space->Size()) {
+                    	char *buffer = new char[numChar];
                     	status = SysRead(buffer, numChar, fileID);
-		    }
+                    	if (status > 0 &&
+                    	    !kernel->currentThread->space->CopyOut(val, buffer, status))
+                    	    status = -1;
+                    	delete[] buffer;
+                    }
                     kernel->machine->WriteRegister(2, (int) status);
 		    //cout << status << " Bytes read." << endl;
                     kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg)); 
@@ -192,12 +215,89 @@ void ExceptionHandler(ExceptionType which) {
                     return;
                     ASSERTNOTREACHED();
                     break;
+                case SC_Send:
+                    val = kernel->machine->ReadRegister(6);
+                    numChar = kernel->machine->ReadRegister(7);
+                    status = -1;
+                    if (numChar >= 0 && numChar <= (int)MaxMailSize) {
+                        char buffer[MaxMailSize];
+                        if (kernel->currentThread->space->CopyIn(val, buffer, numChar))
+                            status = SysSend(kernel->machine->ReadRegister(4),
+                                             kernel->machine->ReadRegister(5),
+                                             buffer, numChar);
+                    }
+                    kernel->machine->WriteRegister(2, (int)status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_Receive:
+                    val = kernel->machine->ReadRegister(5);
+                    numChar = kernel->machine->ReadRegister(6);
+                    status = -1;
+                    if (numChar >= 0) {
+                        Mail *mail = SysReceive(kernel->machine->ReadRegister(4));
+                        if (mail != NULL) {
+                            // straight from the packet buffer to the user
+                            status = min(numChar, (int)mail->mailHdr.length);
+                            if (!kernel->currentThread->space->CopyOut(val, mail->data, status))
+                                status = -1;
+                            else
+                                kernel->stats->numMailBytesCopied += status;
+                            delete mail;
+                        }
+                    }
+                    kernel->machine->WriteRegister(2, (int)status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
+                case SC_ReadLine:
+                    val = kernel->machine->ReadRegister(4);
+                    numChar = kernel->machine->ReadRegister(5);
+                    status = -1;
+                    // room for at least one character and the null
+                    if (numChar >= 2) {
+                        char *buffer = new char[numChar];
+                        status = SysReadLine(buffer, numChar - 1);
+                        buffer[status] = '\0';
+                        if (!kernel->currentThread->space->CopyOut(val, buffer, status + 1))
+                            status = -1;
+                        delete[] buffer;
+                    }
+                    kernel->machine->WriteRegister(2, (int)status);
+                    kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+                    return;
+                    ASSERTNOTREACHED();
+                    break;
                 break;
 		default:
                     cerr << "Unexpected system call " << type << "\n";
                     break;
             }
             break;
+        case PageFaultException:
+            // bring the page in and retry the faulting instruction,
+            // so don't advance the program counter
+            val = kernel->machine->ReadRegister(BadVAddrReg);
+            DEBUG(dbgAddr, "Page fault at " << val);
+            kernel->stats->numPageFaults++;
+            kernel->currentThread->space->PageFault(val / PageSize);
+            return;
+        case ReadOnlyException:
+            // a write to a page shared with other copies of the same
+            // program; give this one its own copy and retry -- unless
+            // it is code or read-only data, which is never written
+            val = kernel->machine->ReadRegister(BadVAddrReg);
+            if (kernel->currentThread->space->CopyOnWrite(val / PageSize))
+                return;
+            // fall through
         default:
             cerr << "Unexpected user mode exception " << (int)which << "\n";
             break;
@@ -0,0 +1,462 @@
+// frametable.cc
+//	Routines to manage physical page frames and the swap area.
+//
+//	When no frame is free, a victim is chosen with the enhanced
+//	second chance (CLOCK) algorithm, using the use and dirty bits
+//	that Machine::Translate sets in the owner's page table:
+//
+//	   1. sweep once looking for a page that is neither used nor
+//	      dirty -- it can be reclaimed without any I/O;
+//	   2. sweep again looking for an unused dirty page, clearing
+//	      the use bit of every page passed over;
+//	   3. repeat; by now every use bit is clear, so we are sure
+//	      to find a victim.
+//
+//	A dirty victim is written to its swap slot before the frame
+//	is handed over; a clean victim already has a good copy there.
+//	Pages shared between copies of the same executable are never
+//	dirty (they are mapped read-only), and count as used if any
+//	of the address spaces sharing them has used them.  Without a
+//	swap area, only shared pages are ever evicted.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "frametable.h"
+
+#include "addrspace.h"
+#include "copyright.h"
+#include "main.h"
+#include "synch.h"
+#include "synchdisk.h"
+
+//----------------------------------------------------------------------
+// FrameAllocator::FrameAllocator
+// 	Initialize the free list, with every frame free, lowest
+//	numbered frames first.
+//----------------------------------------------------------------------
+
+FrameAllocator::FrameAllocator(int numFrames) {
+    next = new int[numFrames];
+    for (int i = 0; i < numFrames; i++)
+        next[i] = i + 1;
+    next[numFrames - 1] = -1;
+    head = 0;
+    numFree = numFrames;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::~FrameAllocator
+// 	De-allocate the free list.
+//----------------------------------------------------------------------
+
+FrameAllocator::~FrameAllocator() { delete[] next; }
+
+//----------------------------------------------------------------------
+// FrameAllocator::Allocate
+// 	Take a frame off the free list; return -1 if there is none.
+//----------------------------------------------------------------------
+
+int FrameAllocator::Allocate() {
+    int frame = head;
+
+    if (frame != -1) {
+        head = next[frame];
+        numFree--;
+    }
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Allocate
+// 	Take "count" frames off the free list, storing them in "frames".
+//	If there are not that many free frames, take none and return FALSE.
+//----------------------------------------------------------------------
+
+bool FrameAllocator::Allocate(int count, int *frames) {
+    if (count > numFree)
+        return FALSE;
+    for (int i = 0; i < count; i++) {
+        frames[i] = head;
+        head = next[head];
+    }
+    numFree -= count;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Free
+// 	Put a frame back on the free list.
+//----------------------------------------------------------------------
+
+void FrameAllocator::Free(int frame) {
+    next[frame] = head;
+    head = frame;
+    numFree++;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Free
+// 	Put "count" frames back on the free list.  They are pushed in
+//	reverse, so they come back out in the order they are given.
+//----------------------------------------------------------------------
+
+void FrameAllocator::Free(int count, int *frames) {
+    for (int i = count - 1; i >= 0; i--) {
+        next[frames[i]] = head;
+        head = frames[i];
+    }
+    numFree += count;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FrameTable
+// 	Initialize the frame table; all frames and swap slots start
+//	out free.
+//----------------------------------------------------------------------
+
+FrameTable::FrameTable() {
+    ASSERT(PageSize == SectorSize);  // a page is swapped as one sector
+    frames = new FrameEntry[NumPhysPages];
+    for (int i = 0; i < NumPhysPages; i++) {
+        frames[i].owner = NULL;
+        frames[i].image = NULL;
+        frames[i].vpn = -1;
+        frames[i].refCount = 0;
+    }
+    freeFrames = new FrameAllocator(NumPhysPages);
+    hand = 0;
+    numReserved = 0;
+    swapMap = new Bitmap(NumSwapPages);
+    pagingLock = new Lock("paging");
+    images = new List<SharedImage *>;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::~FrameTable
+// 	De-allocate the frame table.
+//----------------------------------------------------------------------
+
+FrameTable::~FrameTable() {
+    delete[] frames;
+    delete freeFrames;
+    delete swapMap;
+    delete pagingLock;
+    delete images;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::LockPaging, FrameTable::UnlockPaging
+// 	Serialize page faults, program loading, and page I/O.
+//----------------------------------------------------------------------
+
+void FrameTable::LockPaging() { pagingLock->Acquire(); }
+
+void FrameTable::UnlockPaging() { pagingLock->Release(); }
+
+//----------------------------------------------------------------------
+// FrameTable::Allocate
+// 	Return a frame to hold the private virtual page "vpn" of "space".
+//	The contents of the returned frame are undefined.
+//
+//	The caller must hold the paging lock.
+//----------------------------------------------------------------------
+
+int FrameTable::Allocate(AddrSpace *space, int vpn) {
+    int frame = GetFrame();
+
+    frames[frame].owner = space;
+    frames[frame].vpn = vpn;
+    frames[frame].refCount = 1;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateReserved
+// 	Like Allocate, but use one of the free frames set aside with
+//	Reserve, so no page has to be evicted.
+//
+//	The caller must hold the paging lock.
+//----------------------------------------------------------------------
+
+int FrameTable::AllocateReserved(AddrSpace *space, int vpn) {
+    ASSERT(numReserved > 0 && freeFrames->NumFree() >= numReserved);
+    numReserved--;
+    return Allocate(space, vpn);  // there is a free frame for us
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateShared
+// 	Return a frame to hold page "vpn" of executable "image", mapped
+//	by one address space so far.  The contents of the returned frame
+//	are undefined.
+//
+//	The caller must hold the paging lock.
+//----------------------------------------------------------------------
+
+int FrameTable::AllocateShared(SharedImage *image, int vpn) {
+    int frame = GetFrame();
+
+    frames[frame].image = image;
+    frames[frame].vpn = vpn;
+    frames[frame].refCount = 1;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateBulk
+// 	Find frames for the private virtual pages "vpns" of "space",
+//	storing them in "frameNums", if there are "count" free frames.
+//	Otherwise, allocate nothing and return FALSE; the caller should
+//	allocate one page at a time, evicting as needed.
+//
+//	The caller must hold the paging lock.
+//----------------------------------------------------------------------
+
+bool FrameTable::AllocateBulk(AddrSpace *space, int count, int *vpns,
+                              int *frameNums) {
+    if (count > NumFree() || !freeFrames->Allocate(count, frameNums))
+        return FALSE;
+    for (int i = 0; i < count; i++) {
+        FrameEntry *entry = &frames[frameNums[i]];
+
+        entry->owner = space;
+        entry->vpn = vpns[i];
+        entry->refCount = 1;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateSharedBulk
+// 	Like AllocateBulk, for the pages "vpns" of executable "image",
+//	each mapped by one address space so far.
+//----------------------------------------------------------------------
+
+bool FrameTable::AllocateSharedBulk(SharedImage *image, int count, int *vpns,
+                                    int *frameNums) {
+    if (count > NumFree() || !freeFrames->Allocate(count, frameNums))
+        return FALSE;
+    for (int i = 0; i < count; i++) {
+        FrameEntry *entry = &frames[frameNums[i]];
+
+        entry->image = image;
+        entry->vpn = vpns[i];
+        entry->refCount = 1;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Share
+// 	Note that one more address space maps a shared frame.
+//----------------------------------------------------------------------
+
+void FrameTable::Share(int frame) {
+    ASSERT(frames[frame].image != NULL && frames[frame].refCount > 0);
+    frames[frame].refCount++;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Free
+// 	Drop one mapping of a frame, and give the frame back once
+//	nobody maps it.  Return the number of mappings left.
+//
+//	This only updates the table, so it is safe to call from code
+//	that cannot block.
+//----------------------------------------------------------------------
+
+int FrameTable::Free(int frame) {
+    ASSERT(frames[frame].refCount > 0);
+    if (--frames[frame].refCount == 0) {
+        frames[frame].owner = NULL;
+        frames[frame].image = NULL;
+        frames[frame].vpn = -1;
+        freeFrames->Free(frame);
+    }
+    return frames[frame].refCount;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FreeBulk
+// 	Give back "count" private frames at once.  Like Free, this only
+//	updates the table.
+//----------------------------------------------------------------------
+
+void FrameTable::FreeBulk(int count, int *frameNums) {
+    for (int i = 0; i < count; i++) {
+        FrameEntry *entry = &frames[frameNums[i]];
+
+        ASSERT(entry->refCount == 1 && entry->image == NULL);
+        entry->owner = NULL;
+        entry->vpn = -1;
+        entry->refCount = 0;
+    }
+    freeFrames->Free(count, frameNums);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::GetFrame
+// 	Find a frame that is not in use (or set aside).  If there is
+//	none, evict a page, writing it out to swap first if it has been
+//	modified.
+//
+//	The caller must hold the paging lock.
+//----------------------------------------------------------------------
+
+int FrameTable::GetFrame() {
+    FrameEntry *victim;
+    int frame;
+
+    if (NumFree() > 0)
+        return freeFrames->Allocate();
+
+    frame = FindVictim();
+    // without swap, AddrSpace::Load leaves room for shared pages
+    ASSERT(frame != -1);
+    victim = &frames[frame];
+    if (victim->image != NULL) {
+        // shared pages are clean; just drop every mapping
+        DEBUG(dbgAddr, "Evicting shared page " << victim->vpn << " from frame " << frame);
+        victim->image->Evict(victim->vpn);
+    } else {
+        TranslationEntry *entry = victim->owner->PageEntry(victim->vpn);
+
+        // take the page away from its owner before we can block on
+        // the disk, so the owner faults (and waits for us) if it runs
+        entry->valid = FALSE;
+        DEBUG(dbgAddr, "Evicting page " << victim->vpn << " from frame " << frame
+                                        << (entry->dirty ? ", dirty" : ", clean"));
+        if (entry->dirty) {
+            int slot = victim->owner->SwapSlot(victim->vpn);
+
+            victim->owner = NULL;  // owner may go away while we wait
+            PageOut(slot, frame);
+            kernel->stats->numPageOuts++;
+        }
+    }
+    victim->owner = NULL;
+    victim->image = NULL;
+    victim->vpn = -1;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FindVictim
+// 	Run the CLOCK hand around physical memory to choose a frame
+//	to evict, preferring pages that are clean (see the comment at
+//	the top of the file).  All frames must be in use.  Return -1 if
+//	none of them can be evicted: there is no swap area, and every
+//	frame holds a private page.
+//----------------------------------------------------------------------
+
+int FrameTable::FindVictim() {
+    for (int pass = 0;; pass++) {
+        bool evictable = FALSE;
+
+        for (int i = 0; i < NumPhysPages; i++) {
+            int frame = hand;
+            FrameEntry *victim = &frames[frame];
+            TranslationEntry *entry;
+
+            hand = (hand + 1) % NumPhysPages;
+            if (victim->image != NULL) {
+                // shared pages are never dirty
+                evictable = TRUE;
+                if (!victim->image->Referenced(victim->vpn, pass % 2 == 1) &&
+                    pass % 2 == 0)
+                    return frame;
+                continue;
+            }
+            if (NumSwapPages == 0)
+                continue;  // a private page has nowhere to go
+            evictable = TRUE;
+            entry = victim->owner->PageEntry(victim->vpn);
+            if (pass % 2 == 0) {
+                if (!entry->use && !entry->dirty)
+                    return frame;
+            } else {
+                if (!entry->use && entry->dirty)
+                    return frame;
+                entry->use = FALSE;  // second chance
+            }
+        }
+        if (!evictable)
+            return -1;
+    }
+    ASSERTNOTREACHED();
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::OpenImage
+// 	Return the shared image of executable "fileName", opening the
+//	file if no other address space is running it.  Return NULL if
+//	the file cannot be opened.
+//
+//	The caller must hold the paging lock.
+//----------------------------------------------------------------------
+
+SharedImage *FrameTable::OpenImage(char *fileName) {
+    ListIterator<SharedImage *> iter(images);
+    OpenFile *executable;
+    SharedImage *image;
+
+    for (; !iter.IsDone(); iter.Next()) {
+        if (strcmp(iter.Item()->getName(), fileName) == 0)
+            return iter.Item();
+    }
+
+    executable = kernel->fileSystem->Open(fileName);
+    if (executable == NULL)
+        return NULL;
+    image = new SharedImage(fileName, executable);
+    images->Append(image);
+    return image;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::CloseImage
+// 	Address space "space" no longer runs "image"; close the image
+//	once nobody does.  All of its pages must have been unmapped by
+//	"space" already.  "space" is NULL if the caller opened the image
+//	but never became one of its users.
+//----------------------------------------------------------------------
+
+void FrameTable::CloseImage(SharedImage *image, AddrSpace *space) {
+    if (space != NULL ? image->RemoveUser(space) : !image->HasUsers()) {
+        images->Remove(image);
+        delete image;
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateSwap, FrameTable::FreeSwap,
+// FrameTable::NumFreeSwap
+// 	Manage the slots of the swap area.
+//----------------------------------------------------------------------
+
+int FrameTable::AllocateSwap() { return swapMap->FindAndSet(); }
+
+void FrameTable::FreeSwap(int slot) { swapMap->Clear(slot); }
+
+int FrameTable::NumFreeSwap() { return swapMap->NumClear(); }
+
+//----------------------------------------------------------------------
+// FrameTable::PageIn, FrameTable::PageOut
+// 	Move a page between physical memory and the swap area.
+//	The calling thread waits for the disk.
+//----------------------------------------------------------------------
+
+void FrameTable::PageIn(int slot, int frame) {
+    DEBUG(dbgAddr, "Page in: swap slot " << slot << " to frame " << frame);
+    kernel->synchDisk->ReadSector(
+        slot, &(kernel->machine->mainMemory[frame * PageSize]));
+}
+
+void FrameTable::PageOut(int slot, int frame) {
+    DEBUG(dbgAddr, "Page out: frame " << frame << " to swap slot " << slot);
+    kernel->synchDisk->WriteSector(
+        slot, &(kernel->machine->mainMemory[frame * PageSize]));
+}
@@ -0,0 +1,145 @@
+// frametable.h
+//	Data structures to keep track of physical page frames, and
+//	of the swap area used to hold pages that have been evicted.
+//
+//	Every frame of physical memory records which address space
+//	it belongs to (or, for pages shared between several copies of
+//	the same program, which executable image) and which virtual page
+//	it holds, so that when memory runs out we can pick a victim with
+//	the CLOCK algorithm (enhanced second chance), write it back to
+//	swap if it is dirty, and invalidate the page table entries that
+//	map it.
+//
+//	The swap area is a range of sectors on the raw simulated disk.
+//	With the stub file system the disk is otherwise unused; with
+//	the real file system the disk belongs to the file system, and
+//	no swap space is available.  Private pages then stay in memory
+//	until their address space goes away, and a frame is set aside
+//	when a program is loaded for every page it may copy-on-write.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "bitmap.h"
+#include "copyright.h"
+#include "disk.h"
+#include "list.h"
+#include "machine.h"
+
+class AddrSpace;
+class Lock;
+class SharedImage;
+
+#ifdef FILESYS_STUB
+#define NumSwapPages NumSectors  // one page per disk sector
+#else
+#define NumSwapPages 0  // disk is owned by the file system
+#endif
+
+// The following class keeps track of which physical frames are free.
+// The free frames are kept on a stack threaded through an array, so
+// that a frame can be allocated or freed in constant time, no matter
+// how large physical memory is.  Frames are handed out in increasing
+// order to begin with, so a fresh allocation tends to be contiguous.
+
+class FrameAllocator {
+   public:
+    FrameAllocator(int numFrames);  // Initialize all frames to be free
+    ~FrameAllocator();              // De-allocate the free list
+
+    int Allocate();  // Return a free frame, or -1 if there is none
+    bool Allocate(int count, int *frames);  // Return "count" free
+                                            // frames, all or nothing
+    void Free(int frame);               // Give a frame back
+    void Free(int count, int *frames);  // Give "count" frames back
+
+    int NumFree() { return numFree; }  // frames that are not in use
+
+   private:
+    int *next;    // the free frame after each free frame, or -1
+    int head;     // first free frame, or -1
+    int numFree;  // number of free frames
+};
+
+// The following class records who is using a physical page frame.
+
+class FrameEntry {
+   public:
+    AddrSpace *owner;     // address space with a private page
+                          // in this frame
+    SharedImage *image;   // executable with a shared page in
+                          // this frame
+    int vpn;              // virtual page held in this frame
+    int refCount;         // number of address spaces mapping
+                          // this frame, 0 if the frame is free
+};
+
+// The following class defines the global table of physical frames.
+//
+// All paging activity (allocating frames, evicting pages, moving
+// pages to and from swap) is done while holding the paging lock,
+// so only one page fault is serviced at a time.  Frames are given
+// back with Free, which only does bookkeeping and so can be
+// called when the caller cannot block (e.g., from ~AddrSpace).
+
+class FrameTable {
+   public:
+    FrameTable();   // Initialize all frames to be free
+    ~FrameTable();  // De-allocate the frame table
+
+    void LockPaging();    // serialize paging activity
+    void UnlockPaging();
+
+    int Allocate(AddrSpace *space, int vpn);  // Find a frame to hold
+                                              // "vpn" of "space",
+                                              // evicting a page if needed
+    int AllocateShared(SharedImage *image, int vpn);  // Same, for a
+                                                      // shared page
+    bool AllocateBulk(AddrSpace *space, int count, int *vpns, int *frameNums);
+                                              // Find frames for "count"
+                                              // pages at once, if that
+                                              // many are free
+    bool AllocateSharedBulk(SharedImage *image, int count, int *vpns,
+                            int *frameNums);  // Same, for shared pages
+    void Share(int frame);                    // One more mapping
+    int Free(int frame);                      // One less mapping; returns
+                                              // how many are left
+    void FreeBulk(int count, int *frameNums);  // Give back "count"
+                                               // private frames at once
+
+    SharedImage *OpenImage(char *fileName);   // Find or open the image
+                                              // of an executable
+    void CloseImage(SharedImage *image, AddrSpace *space);
+
+    int NumFree() { return freeFrames->NumFree() - numReserved; }
+                                              // frames not in use, and
+                                              // not set aside
+    void Reserve(int count) { numReserved += count; }    // Set aside
+    void Unreserve(int count) { numReserved -= count; }  // free frames
+    int AllocateReserved(AddrSpace *space, int vpn);  // Allocate, using
+                                                      // a frame set aside
+
+    int AllocateSwap();          // Reserve a swap slot, -1 if none left
+    void FreeSwap(int slot);     // Give a swap slot back
+    int NumFreeSwap();           // swap slots that are not in use
+    void PageIn(int slot, int frame);   // Read "slot" into "frame"
+    void PageOut(int slot, int frame);  // Write "frame" to "slot"
+
+   private:
+    FrameEntry *frames;               // who owns each frame
+    FrameAllocator *freeFrames;       // which frames are free
+    int hand;                         // CLOCK hand
+    int numReserved;                  // free frames set aside
+    Bitmap *swapMap;                  // which swap slots are in use
+    Lock *pagingLock;                 // serializes page faults
+    List<SharedImage *> *images;      // executables being run
+
+    int GetFrame();    // Find a free frame, evicting if needed
+    int FindVictim();  // Choose a frame to evict, -1 if none can be
+};
+
+#endif  // FRAMETABLE_H
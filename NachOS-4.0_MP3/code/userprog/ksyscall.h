@@ -12,7 +12,9 @@
 #define __USERPROG_KSYSCALL_H__
 
 #include "kernel.h"
+#include "post.h"
 #include "synchconsole.h"
+#include "syscall.h"
 
 void SysHalt() {
     kernel->interrupt->Halt();
@@ -40,14 +42,51 @@ int SysClose(OpenFileId id) {
 }
 
 int SysRead(char *buffer, int size, OpenFileId id) {
+  if (id == SysConsoleInput) {  // at most one line, in one transfer
+    return kernel->synchConsoleIn->GetLine(buffer, size);
+  }
   return kernel->fileSystem->ReadFile(buffer, size, id);
 }
 
+int SysReadLine(char *buffer, int size) {
+  return kernel->synchConsoleIn->GetLine(buffer, size);
+}
+
 int SysWrite(char *buffer, int size, OpenFileId id) {
+  if (id == SysConsoleOutput) {  // the whole buffer in one transfer
+    kernel->synchConsoleOut->PutBuffer(buffer, size);
+    return size;
+  }
   return kernel->fileSystem->WriteFile(buffer, size, id);
 }
 
 
+int SysSend(int host, int box, char *data, int size) {
+  PacketHeader pktHdr;
+  MailHeader mailHdr;
+
+  if (kernel->postOfficeOut == NULL || size < 0 || size > (int)MaxMailSize ||
+      host < 0 || box < 0 || box >= kernel->postOfficeIn->NumBoxes()) {
+    return -1;
+  }
+  pktHdr.to = host;
+  mailHdr.to = box;
+  mailHdr.from = box;  // replies come back to the same box here
+  mailHdr.length = size;
+  kernel->postOfficeOut->Send(pktHdr, mailHdr, data);
+  return size;
+}
+
+// The message is handed over, not copied; the caller copies it
+// straight to user memory, then deletes it.
+Mail *SysReceive(int box) {
+  if (kernel->postOfficeIn == NULL || box < 0 ||
+      box >= kernel->postOfficeIn->NumBoxes()) {
+    return NULL;
+  }
+  return kernel->postOfficeIn->Receive(box);
+}
+
 // When you finish the function "OpenAFile", you can remove the comment below.
 
 OpenFileId SysOpen(char *name)
@@ -9,6 +9,7 @@
 #include "synchconsole.h"
 
 #include "copyright.h"
+#include "main.h"
 
 //----------------------------------------------------------------------
 // SynchConsoleInput::SynchConsoleInput
@@ -22,6 +23,10 @@ SynchConsoleInput::SynchConsoleInput(char *inputFile) {
     consoleInput = new ConsoleInput(inputFile, this);
     lock = new Lock("console in");
     waitFor = new Semaphore("console in", 0);
+    lineLength = lineRead = 0;
+    canonical = TRUE;
+    echo = FALSE;
+    atEnd = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -38,18 +43,104 @@ SynchConsoleInput::~SynchConsoleInput() {
 //----------------------------------------------------------------------
 // SynchConsoleInput::GetChar
 //      Read a character typed at the keyboard, waiting if necessary.
+//	Whatever is left of a line assembled by GetLine comes first.
 //----------------------------------------------------------------------
 
 char SynchConsoleInput::GetChar() {
     char ch;
 
     lock->Acquire();
+    if (lineRead < lineLength) {
+        ch = line[lineRead++];
+    } else {
+        ch = ReadChar();
+    }
+    lock->Release();
+    return ch;
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleInput::GetLine
+//      Read up to "size" characters of the current input line into
+//	"buffer", assembling the next line first if the last one has
+//	all been read.  A line longer than "size" is handed out over
+//	several calls.  Return the number of characters read; 0 means
+//	the input has run out.
+//----------------------------------------------------------------------
+
+int SynchConsoleInput::GetLine(char *buffer, int size) {
+    int numRead;
+
+    lock->Acquire();
+    if (lineRead == lineLength) {
+        FillLine();
+    }
+    numRead = min(size, lineLength - lineRead);
+    bcopy(line + lineRead, buffer, numRead);
+    lineRead += numRead;
+    lock->Release();
+    return numRead;
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleInput::ReadChar
+//      Wait for the next character from the keyboard, or EOF.  Once
+//	the input has run out there will be no more interrupts, so
+//	don't wait for one.  The caller holds the lock.
+//----------------------------------------------------------------------
+
+char SynchConsoleInput::ReadChar() {
+    char ch;
+
+    if (atEnd) {
+        return EOF;
+    }
     waitFor->P();  // wait for EOF or a char to be available.
     ch = consoleInput->GetChar();
-    lock->Release();
+    if (ch == EOF) {
+        atEnd = TRUE;
+    }
     return ch;
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleInput::FillLine
+//      Assemble the next line of input.  In canonical mode, read
+//	until a newline, the end of the input, or a full buffer, and
+//	let backspace take back the last character; otherwise take
+//	just the next character.  Echo what is typed, if asked to.
+//----------------------------------------------------------------------
+
+void SynchConsoleInput::FillLine() {
+    char ch;
+    char erase[] = "\b \b";  // back up over a character on the display
+
+    lineLength = lineRead = 0;
+    while (lineLength < MaxLineLength) {
+        ch = ReadChar();
+        if (ch == EOF) {
+            break;
+        }
+        if (canonical && (ch == '\b' || ch == '\177')) {
+            if (lineLength > 0) {
+                lineLength--;
+                if (echo) {
+                    kernel->synchConsoleOut->PutString(erase);
+                }
+            }
+            continue;
+        }
+        line[lineLength++] = ch;
+        if (echo) {
+            kernel->synchConsoleOut->PutChar(ch);
+        }
+        if (!canonical || ch == '\n') {
+            break;
+        }
+    }
+    DEBUG(dbgTraCode, "In SynchConsoleInput::FillLine, " << lineLength << " characters, " << kernel->stats->totalTicks);
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleInput::CallBack
 //      Interrupt handler called when keystroke is hit; wake up
@@ -97,25 +188,45 @@ void SynchConsoleOutput::PutChar(char ch) {
     lock->Release();
 }
 
-void SynchConsoleOutput::PutInt(int value) {
-    char str[15];
-    int idx = 0;
-    // sprintf(str, "%d\n\0", value);  the true one
-    sprintf(str, "%d\n\0", value);  // simply for trace code
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutBuffer
+//      Write "size" characters to the console display, handing them
+//	to the device all at once, and wait until it is done with them.
+//----------------------------------------------------------------------
+
+void SynchConsoleOutput::PutBuffer(char *buffer, int size) {
+    if (size <= 0) {
+        return;
+    }
     lock->Acquire();
-    do {
-        DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, into consoleOutput->PutChar, " << kernel->stats->totalTicks);
-        consoleOutput->PutChar(str[idx]);
-        DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, return from consoleOutput->PutChar, " << kernel->stats->totalTicks);
-        idx++;
-
-        DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, into waitFor->P(), " << kernel->stats->totalTicks);
-        waitFor->P();
-        DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, return form  waitFor->P(), " << kernel->stats->totalTicks);
-    } while (str[idx] != '\0');
+    DEBUG(dbgTraCode, "In SynchConsoleOutput::PutBuffer, into consoleOutput->PutBuffer, " << kernel->stats->totalTicks);
+    consoleOutput->PutBuffer(buffer, size);
+    waitFor->P();
+    DEBUG(dbgTraCode, "In SynchConsoleOutput::PutBuffer, return from waitFor->P(), " << kernel->stats->totalTicks);
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutString
+//      Write a null-terminated string to the console display.
+//----------------------------------------------------------------------
+
+void SynchConsoleOutput::PutString(char *str) {
+    PutBuffer(str, strlen(str));
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutInt
+//      Write a number, and a newline, to the console display.
+//----------------------------------------------------------------------
+
+void SynchConsoleOutput::PutInt(int value) {
+    char str[15];
+
+    sprintf(str, "%d\n", value);
+    PutString(str);
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleOutput::CallBack
 //      Interrupt handler called when it's safe to send the next
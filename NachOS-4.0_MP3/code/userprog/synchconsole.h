@@ -17,8 +17,16 @@
 #include "synch.h"
 #include "utility.h"
 
+const int MaxLineLength = 256;  // longest line GetLine will assemble
+
 // The following two classes define synchronized input and output to
 // a console device
+//
+// Input has a simple line discipline.  In canonical mode, GetLine
+// collects characters until a newline (or end of input), handling
+// backspace as it goes, and only then hands the line to the caller;
+// otherwise it returns as soon as there is any input.  If echo is on,
+// every character taken from the keyboard is written to the display.
 
 class SynchConsoleInput : public CallBackObj {
    public:
@@ -26,12 +34,27 @@ class SynchConsoleInput : public CallBackObj {
     ~SynchConsoleInput();                // Deallocate console device
 
     char GetChar();  // Read a character, waiting if necessary
+    int GetLine(char *buffer, int size);
+                     // Read up to "size" characters of
+                     // the current line, waiting if necessary
+
+    void SetCanonical(bool on) { canonical = on; }
+    void SetEcho(bool on) { echo = on; }
 
    private:
     ConsoleInput *consoleInput;  // the hardware keyboard
     Lock *lock;                  // only one reader at a time
     Semaphore *waitFor;          // wait for callBack
 
+    char line[MaxLineLength];    // the line being assembled
+    int lineLength;              // characters in "line"
+    int lineRead;                // of which have been handed out
+    bool canonical;              // wait for a whole line?
+    bool echo;                   // write input to the display?
+    bool atEnd;                  // has the input run out?
+
+    char ReadChar();  // wait for the next keystroke
+    void FillLine();  // assemble the next line
     void CallBack();  // called when a keystroke is available
 };
 
@@ -41,8 +64,10 @@ class SynchConsoleOutput : public CallBackObj {
     ~SynchConsoleOutput();
 
     void PutChar(char ch);  // Write a character, waiting if necessary
-
-    void PutInt(int n);
+    void PutBuffer(char *buffer, int size);
+                            // Write "size" characters at once
+    void PutString(char *str);  // Write a null-terminated string
+    void PutInt(int n);         // Write a number and a newline
 
    private:
     ConsoleOutput *consoleOutput;  // the hardware display
@@ -35,6 +35,9 @@
 #define SC_ThreadExit 14
 #define SC_ThreadJoin 15
 #define SC_PrintInt 16
+#define SC_ReadLine 17
+#define SC_Send 18
+#define SC_Receive 19
 #define SC_Add 42
 #define SC_MSG 100
 #ifndef IN_ASM
@@ -136,9 +139,20 @@ int Write(char *buffer, int size, OpenFileId id);
  * long enough, or if it is an I/O device, and there aren't enough
  * characters to read, return whatever is available (for I/O devices,
  * you should always wait until you can return at least one character).
+ * Reading from SysConsoleInput returns at most one line.
  */
 int Read(char *buffer, int size, OpenFileId id);
 
+/* Read the next line typed at the console into "buffer", up to
+ * "size" - 1 characters, including the newline, and terminate it
+ * with a null.  The whole line is collected by the kernel, so this
+ * is a single system call however long the line is.  A line longer
+ * than the buffer is returned over several calls.
+ * Return the number of characters read, 0 at the end of the input,
+ * or -1 if "size" is less than 2 (no room for a character).
+ */
+int ReadLine(char *buffer, int size);
+
 /* Set the seek position of the open file "id"
  * to the byte "position".
  */
@@ -149,6 +163,24 @@ int Seek(int position, OpenFileId id);
  */
 int Close(OpenFileId id);
 
+/* Network operations: send and receive messages ("mail") between
+ * mailboxes on Nachos machines, which are numbered by "-m".  Mail is
+ * delivered in order, but it may be lost (see "-n"); a message holds
+ * at most MaxMailSize (40) bytes.
+ */
+
+/* Send "size" bytes from "buffer" to mailbox "box" on machine "host".
+ * Replies are to go to the same mailbox number on this machine.
+ * Return "size" on success, a negative error code on failure.
+ */
+int Send(int host, int box, char *buffer, int size);
+
+/* Wait for a message to arrive in mailbox "box" on this machine, and
+ * copy up to "size" bytes of it into "buffer".
+ * Return the number of bytes copied, a negative error code on failure.
+ */
+int Receive(int box, char *buffer, int size);
+
 /* User-level thread operations: Fork and Yield.  To allow multiple
  * threads to run within a user program.
  *
@@ -0,0 +1,225 @@
+/* tracestat.c
+ *
+ * This program reads a scheduler trace written by "nachos -tr <file>",
+ * and prints, for each thread, how many times it was dispatched, how
+ * long it waited on the ready queue, and how long it took to run for
+ * the first time; then histograms, over all threads, of:
+ *
+ *	wait time	-- from joining a ready queue to getting a CPU
+ *	response time	-- from first joining a ready queue to first
+ *			   getting a CPU
+ *	switch latency	-- from the timer deciding to preempt the running
+ *			   thread to the next thread getting the CPU
+ *
+ * All times are in Nachos ticks.  The layout of the trace is in
+ * ../code/threads/tracefmt.h.
+ *
+ * Copyright (c) 1992-1996 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tracefmt.h"
+
+#define NUM_BUCKETS 32	/* histogram buckets: 0, 1, 2-3, 4-7, ... */
+#define MAX_CPUS 64
+
+typedef struct {
+    int seen;		/* does the thread appear in the trace? */
+    int readyAt;	/* when it joined a ready queue, -1 if not ready */
+    int firstReady;	/* when it first did, -1 if it has not yet */
+    int responded;	/* has it got a CPU since firstReady? */
+    int finished;	/* has it finished? the ID may be reused */
+    int runs;		/* times it got a CPU after waiting */
+    long totalWait;	/* ticks spent waiting to get a CPU */
+    int maxWait;	/* longest single wait */
+    int response;	/* ticks before it first got a CPU */
+} ThreadStat;
+
+typedef struct {
+    char *name;
+    long count[NUM_BUCKETS];
+    long total;
+    long sum;
+} Histogram;
+
+static ThreadStat *threads;	/* indexed by thread ID */
+static int numThreads;		/* size of "threads" */
+
+static Histogram waitHist = {"wait time"};
+static Histogram responseHist = {"response time"};
+static Histogram latencyHist = {"switch latency"};
+
+static void
+fatal(char *message, char *arg)
+{
+    fprintf(stderr, "tracestat: %s %s\n", message, arg);
+    exit(1);
+}
+
+/* Return the statistics for thread "id", growing the table if needed. */
+static ThreadStat *
+findThread(int id)
+{
+    if (id < 0)
+	fatal("bad thread ID in trace", "");
+    if (id >= numThreads) {
+	int newSize = (id + 1) * 2;
+	int i;
+
+	threads = (ThreadStat *) realloc(threads, newSize * sizeof(ThreadStat));
+	if (threads == NULL)
+	    fatal("out of memory", "");
+	for (i = numThreads; i < newSize; i++) {
+	    memset(&threads[i], 0, sizeof(ThreadStat));
+	    threads[i].readyAt = threads[i].firstReady = -1;
+	}
+	numThreads = newSize;
+    }
+    threads[id].seen = 1;
+    return &threads[id];
+}
+
+/* Add "value" to histogram "h", in bucket floor(log2(value)) + 1. */
+static void
+addSample(Histogram *h, int value)
+{
+    int bucket = 0;
+
+    while (value >> bucket && bucket < NUM_BUCKETS - 1)
+	bucket++;
+    h->count[bucket]++;
+    h->total++;
+    h->sum += value;
+}
+
+static void
+printHistogram(Histogram *h)
+{
+    long most = 0;
+    int i, j, bars;
+
+    printf("\n%s: %ld samples", h->name, h->total);
+    if (h->total == 0) {
+	printf("\n");
+	return;
+    }
+    printf(", average %ld ticks\n", h->sum / h->total);
+    for (i = 0; i < NUM_BUCKETS; i++)
+	if (h->count[i] > most)
+	    most = h->count[i];
+    for (i = 0; i < NUM_BUCKETS; i++) {
+	if (h->count[i] == 0)
+	    continue;
+	if (i == 0)
+	    printf("%10d          ", 0);
+	else
+	    printf("%10ld - %-7ld", 1L << (i - 1), (1L << i) - 1);
+	printf(" %8ld ", h->count[i]);
+	bars = (int) (h->count[i] * 40 / most);
+	for (j = 0; j < bars; j++)
+	    putchar('#');
+	putchar('\n');
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    TraceHeader header;
+    TraceEvent event;
+    ThreadStat *t;
+    int preemptAt[MAX_CPUS];
+    FILE *fp;
+    int i;
+
+    if (argc != 2)
+	fatal("usage: tracestat", "<trace file>");
+    if ((fp = fopen(argv[1], "rb")) == NULL)
+	fatal("cannot open", argv[1]);
+    if (fread(&header, sizeof(header), 1, fp) != 1
+	|| header.magic != TRACE_MAGIC)
+	fatal("not a Nachos trace:", argv[1]);
+    if (header.version != TRACE_VERSION)
+	fatal("unknown trace version in", argv[1]);
+
+    for (i = 0; i < MAX_CPUS; i++)
+	preemptAt[i] = -1;
+
+    for (i = 0; i < header.numEvents; i++) {
+	if (fread(&event, sizeof(event), 1, fp) != 1)
+	    fatal("trace is truncated:", argv[1]);
+	if (event.cpu < 0 || event.cpu >= MAX_CPUS)
+	    fatal("bad CPU number in", argv[1]);
+	t = findThread(event.thread);
+	switch (event.type) {
+	  case TraceEnqueue:
+	    if (t->finished) {	/* a new thread with the same ID */
+		t->firstReady = -1;
+		t->responded = t->finished = 0;
+	    }
+	    t->readyAt = event.tick;
+	    if (t->firstReady < 0)
+		t->firstReady = event.tick;
+	    break;
+	  case TraceSwitch:
+	    if (t->readyAt >= 0) {
+		int wait = event.tick - t->readyAt;
+
+		addSample(&waitHist, wait);
+		t->runs++;
+		t->totalWait += wait;
+		if (wait > t->maxWait)
+		    t->maxWait = wait;
+		t->readyAt = -1;
+	    }
+	    if (t->firstReady >= 0 && !t->responded) {
+		t->response = event.tick - t->firstReady;
+		addSample(&responseHist, t->response);
+		t->responded = 1;
+	    }
+	    if (preemptAt[event.cpu] >= 0) {
+		addSample(&latencyHist, event.tick - preemptAt[event.cpu]);
+		preemptAt[event.cpu] = -1;
+	    }
+	    break;
+	  case TracePreempt:
+	    preemptAt[event.cpu] = event.tick;
+	    break;
+	  case TraceFinish:
+	    t->readyAt = -1;
+	    t->finished = 1;
+	    break;
+	  case TraceDequeue:
+	  case TraceAging:
+	    break;
+	  default:
+	    fatal("unknown event in", argv[1]);
+	}
+    }
+    fclose(fp);
+
+    printf("%d events", header.numEvents);
+    if (header.numDropped > 0)
+	printf(" (%d older events were lost)", header.numDropped);
+    printf("\n\n%8s %8s %12s %10s %10s\n",
+	   "thread", "runs", "total wait", "max wait", "response");
+    for (i = 0; i < numThreads; i++) {
+	t = &threads[i];
+	if (!t->seen)
+	    continue;
+	printf("%8d %8d %12ld %10d", i, t->runs, t->totalWait, t->maxWait);
+	if (t->responded)
+	    printf(" %10d\n", t->response);
+	else
+	    printf(" %10s\n", "-");
+    }
+    printHistogram(&waitHist);
+    printHistogram(&responseHist);
+    printHistogram(&latencyHist);
+    return 0;
+}